@@ -0,0 +1,252 @@
+/******************************************************************************
+ * @file jcdp/calibration.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides a calibration of
+ *        the fma cost model for the host: dense multiplications are weighted
+ *        with their measured seconds per fma, tangent / adjoint evaluations
+ *        with their measured seconds per DAG edge, so that the optimizers
+ *        minimize the predicted time.
+ ******************************************************************************/
+
+#ifndef JCDP_CALIBRATION_HPP_
+#define JCDP_CALIBRATION_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <print>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "jcdp/jacobian.hpp"
+#include "jcdp/jacobian_chain.hpp"
+#include "jcdp/util/properties.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp {
+
+//! A calibration file is a config file with the three weights, e.g.
+//!
+//! multiplication_weight 2.1e-10
+//! tangent_weight 9.5e-10
+//! adjoint_weight 2.7e-09
+class Calibration : public util::Properties {
+ public:
+   Calibration() {
+      register_property(
+           m_multiplication_weight, "multiplication_weight",
+           "Seconds per fma of a dense multiplication.");
+      register_property(
+           m_tangent_weight, "tangent_weight",
+           "Seconds per DAG edge of a tangent evaluation.");
+      register_property(
+           m_adjoint_weight, "adjoint_weight",
+           "Seconds per DAG edge of an adjoint evaluation.");
+   }
+
+   //! Measures the weights on this host. Multiplications are measured for
+   //! square matrices over the size range, evaluations with synthetic
+   //! kernels that perform one fma per edge of a random DAG over the DAG
+   //! size range (plus recording and reading a tape in adjoint mode). Each
+   //! weight is the mean over the given amount of samples (at least one).
+   inline auto measure(
+        const std::pair<std::size_t, std::size_t>& size_range,
+        const std::pair<std::size_t, std::size_t>& dag_size_range,
+        const std::size_t samples = 8) -> void {
+      if (samples == 0) {
+         throw std::invalid_argument("At least one sample is required.");
+      }
+
+      m_multiplication_weight = 0.0;
+      for (const std::size_t size : geometric(size_range, samples)) {
+         const double fma = static_cast<double>(size * size * size);
+         m_multiplication_weight += time_multiplication(size) / fma;
+      }
+      m_multiplication_weight /= static_cast<double>(samples);
+
+      m_tangent_weight = 0.0;
+      m_adjoint_weight = 0.0;
+      for (const std::size_t edges : geometric(dag_size_range, samples)) {
+         const Dag dag(edges, m_rng);
+         m_tangent_weight += time_tangent(dag) / static_cast<double>(edges);
+         m_adjoint_weight += time_adjoint(dag) / static_cast<double>(edges);
+      }
+      m_tangent_weight /= static_cast<double>(samples);
+      m_adjoint_weight /= static_cast<double>(samples);
+   }
+
+   //! Replaces the tangent and adjoint costs of the elementals by the
+   //! measured time of one evaluation of their DAG (edges times weight) in
+   //! multiplication fma, i.e. the generated tangent and adjoint factors are
+   //! superseded. Afterwards all fma are multiplication fma and the
+   //! predicted time of a sequence is seconds(makespan). Has to be called
+   //! before JacobianChain::init_subchains.
+   inline auto apply(JacobianChain& chain) const -> void {
+      if (m_multiplication_weight <= 0) {
+         throw std::runtime_error("Invalid multiplication weight.");
+      }
+
+      auto scale = [](const std::size_t cost, const double weight) {
+         if (cost == 0) {
+            return cost;
+         }
+         return std::max<std::size_t>(
+              static_cast<std::size_t>(
+                   std::llround(static_cast<double>(cost) * weight)),
+              1);
+      };
+
+      for (Jacobian& jac : chain.elemental_jacobians) {
+         jac.tangent_cost = scale(
+              jac.edges_in_dag, m_tangent_weight / m_multiplication_weight);
+         jac.adjoint_cost = scale(
+              jac.edges_in_dag, m_adjoint_weight / m_multiplication_weight);
+      }
+   }
+
+   //! Predicted seconds of the given (calibrated) fma.
+   inline auto seconds(const std::size_t fma) const -> double {
+      return m_multiplication_weight * static_cast<double>(fma);
+   }
+
+   //! Writes the weights as a calibration file (at full precision).
+   inline auto write(const std::filesystem::path& filename) const -> void {
+      std::ofstream out(filename);
+      if (!out) {
+         throw std::runtime_error("Failed to open " + filename.string());
+      }
+
+      std::println(out, "multiplication_weight {}", m_multiplication_weight);
+      std::println(out, "tangent_weight {}", m_tangent_weight);
+      std::println(out, "adjoint_weight {}", m_adjoint_weight);
+   }
+
+   double m_multiplication_weight {1.0};
+   double m_tangent_weight {1.0};
+   double m_adjoint_weight {1.0};
+
+ private:
+   //! Minimum duration of a measurement. Short kernels are repeated.
+   static constexpr double MIN_DURATION = 0.05;
+
+   //! Random DAG in topological order. Every vertex has about two inputs.
+   struct Dag {
+      Dag(const std::size_t edges, std::mt19937_64& rng)
+           : vertices(edges / 2 + 2), source(edges), target(edges),
+             partial(edges) {
+         std::uniform_real_distribution<double> partial_dist(0.0, 0.5);
+         for (std::size_t e = 0; e < edges; ++e) {
+            target[e] = 1 + e * (vertices - 1) / edges;
+            source[e] = std::uniform_int_distribution<std::size_t>(
+                 0, target[e] - 1)(rng);
+            partial[e] = partial_dist(rng);
+         }
+      }
+
+      std::size_t vertices;
+      std::vector<std::size_t> source;
+      std::vector<std::size_t> target;
+      std::vector<double> partial;
+   };
+
+   std::mt19937_64 m_rng {};
+   double m_sink {0.0};
+
+   //! Average seconds of a kernel run.
+   template<typename Kernel>
+   inline auto time(Kernel&& kernel) -> double {
+      std::size_t runs = 0;
+      double duration = 0.0;
+      const auto start = std::chrono::steady_clock::now();
+      while (duration < MIN_DURATION) {
+         m_sink += kernel();
+         ++runs;
+         duration = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+      }
+      return duration / static_cast<double>(runs);
+   }
+
+   inline auto time_multiplication(const std::size_t size) -> double {
+      const std::vector<double> lhs(size * size, 0.5);
+      const std::vector<double> rhs(size * size, 0.5);
+      std::vector<double> out(size * size, 0.0);
+
+      return time([&]() -> double {
+         for (std::size_t i = 0; i < size; ++i) {
+            for (std::size_t k = 0; k < size; ++k) {
+               const double l_ik = lhs[i * size + k];
+               for (std::size_t j = 0; j < size; ++j) {
+                  out[i * size + j] += l_ik * rhs[k * size + j];
+               }
+            }
+         }
+         return out.back();
+      });
+   }
+
+   inline auto time_tangent(const Dag& dag) -> double {
+      std::vector<double> tangents(dag.vertices, 1.0);
+      return time([&]() -> double {
+         for (std::size_t e = 0; e < dag.partial.size(); ++e) {
+            tangents[dag.target[e]] += dag.partial[e] *
+                                       tangents[dag.source[e]];
+         }
+         return tangents.back();
+      });
+   }
+
+   inline auto time_adjoint(const Dag& dag) -> double {
+      std::vector<double> values(dag.vertices, 1.0);
+      std::vector<double> adjoints(dag.vertices, 1.0);
+      std::vector<double> tape;
+      tape.reserve(dag.partial.size());
+
+      return time([&]() -> double {
+         // Forward pass that records the partials on the tape
+         tape.clear();
+         for (std::size_t e = 0; e < dag.partial.size(); ++e) {
+            tape.push_back(dag.partial[e]);
+            values[dag.target[e]] += tape.back() * values[dag.source[e]];
+         }
+
+         for (std::size_t e = dag.partial.size(); e-- > 0;) {
+            adjoints[dag.source[e]] += tape[e] * adjoints[dag.target[e]];
+         }
+         return adjoints.front();
+      });
+   }
+
+   //! Samples spaced geometrically over the range.
+   inline static auto geometric(
+        const std::pair<std::size_t, std::size_t>& range,
+        const std::size_t samples) -> std::vector<std::size_t> {
+      const double first = static_cast<double>(std::max<std::size_t>(
+           range.first, 1));
+      const double last = static_cast<double>(std::max<std::size_t>(
+           range.second, 1));
+
+      std::vector<std::size_t> points(samples);
+      for (std::size_t s = 0; s < samples; ++s) {
+         const double t = (samples > 1) ? static_cast<double>(s) /
+                                               static_cast<double>(samples - 1)
+                                        : 0.0;
+         points[s] = static_cast<std::size_t>(
+              std::llround(first * std::pow(last / first, t)));
+      }
+      return points;
+   }
+};
+
+}  // end namespace jcdp
+
+#endif  // JCDP_CALIBRATION_HPP_
@@ -0,0 +1,348 @@
+/******************************************************************************
+ * @file jcdp/chain_file.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides a reader and a
+ *        writer for files that store Jacobian chains, e.g. chains measured
+ *        from real AD tapes or generated chains that should be replayed.
+ ******************************************************************************/
+
+#ifndef JCDP_CHAIN_FILE_HPP_
+#define JCDP_CHAIN_FILE_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#if defined(__unix__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "jcdp/jacobian.hpp"
+#include "jcdp/jacobian_chain.hpp"
+#include "jcdp/util/properties.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp {
+
+/******************************************************************************
+ * @brief Thrown if a chain file or chain description can't be read.
+ ******************************************************************************/
+class BadChainError : public std::runtime_error {
+ public:
+   using std::runtime_error::runtime_error;
+};
+
+//! Both formats store the following values per elemental Jacobian.
+//!
+//! Text:   "chain <id> <length>" followed by one line per elemental with
+//!         <n> <m> <edges_in_dag> <tangent_cost> <adjoint_cost> <ku> <kl>
+//!         <non_zero_elements>. Lines starting with # are comments.
+//! Binary: The magic BINARY_MAGIC and the version as uint64, followed by
+//!         <id> <length> and the same 8 values per elemental as uint64 in
+//!         native byte order. Can be memory-mapped as a whole.
+enum class ChainFileFormat { TEXT, BINARY };
+
+inline constexpr std::string_view BINARY_MAGIC {"JCDPCHN\0", 8};
+inline constexpr std::uint64_t BINARY_VERSION = 1;
+inline constexpr std::size_t VALUES_PER_JACOBIAN = 8;
+
+//! Values of an elemental Jacobian in the order of the file formats.
+inline auto file_values(Jacobian& jac)
+     -> std::array<std::size_t*, VALUES_PER_JACOBIAN> {
+   return {&jac.n,           &jac.m,           &jac.edges_in_dag,
+           &jac.tangent_cost, &jac.adjoint_cost, &jac.ku,
+           &jac.kl,          &jac.non_zero_elements};
+}
+
+inline auto file_values(const Jacobian& jac)
+     -> std::array<const std::size_t*, VALUES_PER_JACOBIAN> {
+   return {&jac.n,           &jac.m,           &jac.edges_in_dag,
+           &jac.tangent_cost, &jac.adjoint_cost, &jac.ku,
+           &jac.kl,          &jac.non_zero_elements};
+}
+
+//! Initializes the indices of the elementals and checks their sizes.
+inline auto finalize_chain(JacobianChain& chain) -> void {
+   for (std::size_t idx = 0; idx < chain.length(); ++idx) {
+      Jacobian& jac = chain.elemental_jacobians[idx];
+      if (idx > 0 && chain.elemental_jacobians[idx - 1].m != jac.n) {
+         throw BadChainError("Sizes of the elemental Jacobians differ.");
+      }
+      jac.i = idx;
+      jac.j = idx + 1;
+   }
+}
+
+//! Reads "<id> <length>" followed by the values of all elementals from a
+//! text stream, independent of line breaks. The sub-chains are not
+//! initialized.
+inline auto read_chain(std::istream& in, JacobianChain& chain) -> void {
+   std::size_t length = 0;
+   if (!(in >> chain.id >> length) || length == 0) {
+      throw BadChainError("Expected <chain id> <length>.");
+   }
+
+   chain.elemental_jacobians.assign(length, Jacobian {});
+   for (Jacobian& jac : chain.elemental_jacobians) {
+      for (std::size_t* value : file_values(jac)) {
+         if (!(in >> *value)) {
+            throw BadChainError(std::format(
+                 "Expected {} values per elemental Jacobian.",
+                 VALUES_PER_JACOBIAN));
+         }
+      }
+   }
+   finalize_chain(chain);
+}
+
+//! Writes a chain in the text format.
+inline auto write_chain(std::ostream& out, const JacobianChain& chain)
+     -> void {
+   std::println(out, "chain {} {}", chain.id, chain.length());
+   for (const Jacobian& jac : chain.elemental_jacobians) {
+      std::println(
+           out, "{} {} {} {} {} {} {} {}", jac.n, jac.m, jac.edges_in_dag,
+           jac.tangent_cost, jac.adjoint_cost, jac.ku, jac.kl,
+           jac.non_zero_elements);
+   }
+}
+
+/******************************************************************************
+ * @brief Streams the chains of a text or binary chain file one at a time.
+ *        Binary files are memory-mapped (if supported), text files are read
+ *        line by line, so the corpus is never loaded as a whole.
+ ******************************************************************************/
+class ChainFileReader {
+ public:
+   explicit ChainFileReader(const std::filesystem::path& path) {
+      std::ifstream file(path, std::ios::binary);
+      if (!file) {
+         throw BadChainError("Failed to open " + path.string());
+      }
+
+      std::array<char, BINARY_MAGIC.size()> magic {};
+      file.read(magic.data(), magic.size());
+      m_format = (file && std::string_view(magic.data(), magic.size()) ==
+                               BINARY_MAGIC)
+                      ? ChainFileFormat::BINARY
+                      : ChainFileFormat::TEXT;
+
+      if (m_format == ChainFileFormat::TEXT) {
+         m_file.open(path);
+         return;
+      }
+
+#if defined(__unix__)
+      const int fd = open(path.c_str(), O_RDONLY);
+      struct stat stats {};
+      if (fd >= 0 && fstat(fd, &stats) == 0) {
+         m_size = static_cast<std::size_t>(stats.st_size);
+         void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+         m_data = (data == MAP_FAILED) ? nullptr
+                                       : static_cast<const std::byte*>(data);
+      }
+      if (fd >= 0) {
+         close(fd);
+      }
+      if (m_data == nullptr) {
+         throw BadChainError("Failed to map " + path.string());
+      }
+      m_offset = magic.size();
+#else
+      m_file.open(path, std::ios::binary);
+      m_file.seekg(magic.size());
+#endif
+
+      std::uint64_t version = 0;
+      if (!read_binary(version) || version != BINARY_VERSION) {
+         throw BadChainError("Unsupported version of " + path.string());
+      }
+   }
+
+   ChainFileReader(const ChainFileReader&) = delete;
+   auto operator=(const ChainFileReader&) -> ChainFileReader& = delete;
+
+   ~ChainFileReader() {
+#if defined(__unix__)
+      if (m_data != nullptr) {
+         munmap(const_cast<std::byte*>(m_data), m_size);
+      }
+#endif
+   }
+
+   inline auto format() const -> ChainFileFormat {
+      return m_format;
+   }
+
+   //! Reads the next chain. Returns false at the end of the file. The
+   //! sub-chains are not initialized.
+   inline auto next(JacobianChain& chain) -> bool {
+      if (m_format == ChainFileFormat::TEXT) {
+         return next_text(chain);
+      }
+      return next_binary(chain);
+   }
+
+ private:
+   ChainFileFormat m_format {ChainFileFormat::TEXT};
+   std::ifstream m_file {};
+
+   // Memory-mapped binary file
+   const std::byte* m_data {nullptr};
+   std::size_t m_size {0};
+   std::size_t m_offset {0};
+
+   inline auto next_text(JacobianChain& chain) -> bool {
+      std::string token;
+      while (m_file >> token) {
+         if (token.starts_with('#')) {
+            m_file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            continue;
+         }
+         if (token != "chain") {
+            throw BadChainError("Expected 'chain' but got '" + token + "'.");
+         }
+
+         read_chain(m_file, chain);
+         return true;
+      }
+      return false;
+   }
+
+   inline auto next_binary(JacobianChain& chain) -> bool {
+      std::uint64_t id = 0;
+      std::uint64_t length = 0;
+      if (!read_binary(id)) {
+         return false;
+      }
+      if (!read_binary(length) || length == 0) {
+         throw BadChainError("Truncated chain file.");
+      }
+
+      chain.id = id;
+      chain.elemental_jacobians.assign(length, Jacobian {});
+      for (Jacobian& jac : chain.elemental_jacobians) {
+         for (std::size_t* value : file_values(jac)) {
+            std::uint64_t raw = 0;
+            if (!read_binary(raw)) {
+               throw BadChainError("Truncated chain file.");
+            }
+            *value = raw;
+         }
+      }
+      finalize_chain(chain);
+      return true;
+   }
+
+   inline auto read_binary(std::uint64_t& value) -> bool {
+      if (m_data == nullptr) {
+         return static_cast<bool>(m_file.read(
+              static_cast<char*>(static_cast<void*>(&value)), sizeof(value)));
+      }
+
+      if (m_size - m_offset < sizeof(value)) {
+         return false;
+      }
+      std::memcpy(&value, m_data + m_offset, sizeof(value));
+      m_offset += sizeof(value);
+      return true;
+   }
+};
+
+/******************************************************************************
+ * @brief Writes chains to a text or binary chain file. Without an explicit
+ *        format, files with the extension .bin are written in binary.
+ ******************************************************************************/
+class ChainFileWriter {
+ public:
+   explicit ChainFileWriter(const std::filesystem::path& path)
+        : ChainFileWriter(
+               path, (path.extension() == ".bin") ? ChainFileFormat::BINARY
+                                                  : ChainFileFormat::TEXT) {}
+
+   ChainFileWriter(
+        const std::filesystem::path& path, const ChainFileFormat format)
+        : m_format(format) {
+      if (m_format == ChainFileFormat::BINARY) {
+         m_file.open(path, std::ios::binary);
+         m_file.write(BINARY_MAGIC.data(), BINARY_MAGIC.size());
+         write_binary(BINARY_VERSION);
+      } else {
+         m_file.open(path);
+         std::println(
+              m_file,
+              "# n m edges_in_dag tangent_cost adjoint_cost ku kl "
+              "non_zero_elements");
+      }
+
+      if (!m_file) {
+         throw BadChainError("Failed to write " + path.string());
+      }
+   }
+
+   inline auto write(const JacobianChain& chain) -> void {
+      if (m_format == ChainFileFormat::TEXT) {
+         write_chain(m_file, chain);
+      } else {
+         write_binary(chain.id);
+         write_binary(chain.length());
+         for (const Jacobian& jac : chain.elemental_jacobians) {
+            for (const std::size_t* value : file_values(jac)) {
+               write_binary(*value);
+            }
+         }
+      }
+      m_file.flush();
+   }
+
+ private:
+   ChainFileFormat m_format;
+   std::ofstream m_file {};
+
+   inline auto write_binary(const std::uint64_t value) -> void {
+      m_file.write(
+           static_cast<const char*>(static_cast<const void*>(&value)),
+           sizeof(value));
+   }
+};
+
+/******************************************************************************
+ * @brief Config keys of the executables to read chains from a file instead
+ *        of generating them and to save the solved chains for a replay.
+ ******************************************************************************/
+class ChainFileProperties : public util::Properties {
+ public:
+   ChainFileProperties() {
+      register_property(
+           m_chain_file, "chain_file",
+           "Chain file (text or binary) to read the chains from instead of "
+           "generating them.");
+      register_property(
+           m_save_chains, "save_chains",
+           "Chain file to write all solved chains to (binary for .bin).");
+   }
+
+   std::string m_chain_file {};
+   std::string m_save_chains {};
+};
+
+}  // end namespace jcdp
+
+#endif  // JCDP_CHAIN_FILE_HPP_
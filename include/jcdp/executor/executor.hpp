@@ -0,0 +1,283 @@
+/******************************************************************************
+ * @file jcdp/executor/executor.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides an executor that
+ *        runs a scheduled elimination sequence on a (pinned) thread pool via
+ *        user-supplied callbacks and compares the measured times with the
+ *        predicted ones.
+ ******************************************************************************/
+
+#ifndef JCDP_EXECUTOR_EXECUTOR_HPP_
+#define JCDP_EXECUTOR_EXECUTOR_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <format>
+#include <functional>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "jcdp/operation.hpp"
+#include "jcdp/sequence.hpp"
+#include "jcdp/util/properties.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::executor {
+
+//! Evaluates a single operation. Called on the thread the operation is
+//! scheduled on, once all of its operands are available.
+using Callback = std::function<void(const Operation&)>;
+
+struct Callbacks {
+   //! Tangent accumulations and eliminations.
+   Callback tangent {};
+   //! Adjoint accumulations and eliminations.
+   Callback adjoint {};
+   //! Multiplications of two accumulated Jacobians.
+   Callback multiplication {};
+};
+
+//! Measured start and end of an operation in seconds since the run started.
+struct Timing {
+   double start {0.0};
+   double end {0.0};
+};
+
+struct Report {
+   //! Measured times, one per operation of the sequence.
+   std::vector<Timing> timings {};
+   //! Measured makespan in seconds.
+   double makespan {0.0};
+   //! Predicted makespan in fma.
+   std::size_t predicted_makespan {0};
+   //! Seconds per fma, fitted from the measured busy time of all
+   //! operations. Converts the predicted times into seconds.
+   double seconds_per_fma {0.0};
+
+   //! Prints measured vs. predicted times of all operations.
+   inline auto print(std::ostream& out, const Sequence& sequence) const
+        -> void {
+      assert(timings.size() == sequence.length());
+
+      std::println(
+           out, "{:<28} {:>6} {:>23} {:>23}", "Operation", "Thread",
+           "Predicted [s]", "Measured [s]");
+      for (std::size_t op_idx = 0; op_idx < sequence.length(); ++op_idx) {
+         const Operation& op = sequence[op_idx];
+         const double start = seconds(op.start_time);
+         const double end = seconds(op.start_time + op.fma);
+         const std::string name =
+              (op.action == Action::ACCUMULATION)
+                   ? std::format(
+                          "{} {} ({:2} {:2})", op.action, op.mode, op.i,
+                          op.j + 1)
+                   : std::format(
+                          "{} {} ({:2} {:2} {:2})", op.action, op.mode, op.i,
+                          op.k + 1, op.j + 1);
+         std::println(
+              out, "{:<28} {:>6} {:>11.6f}-{:>11.6f} {:>11.6f}-{:>11.6f}",
+              name, op.thread, start, end, timings[op_idx].start,
+              timings[op_idx].end);
+      }
+
+      const double predicted = seconds(predicted_makespan);
+      std::println(
+           out, "\nPredicted makespan: {:.6f} s ({} fma)", predicted,
+           predicted_makespan);
+      std::println(out, "Measured makespan: {:.6f} s", makespan);
+      if (predicted > 0) {
+         std::println(
+              out, "Deviation: {:.2f} %",
+              100.0 * (makespan - predicted) / predicted);
+      }
+   }
+
+   inline auto seconds(const std::size_t fma) const -> double {
+      return seconds_per_fma * static_cast<double>(fma);
+   }
+};
+
+class ExecutorProperties : public util::Properties {
+ public:
+   ExecutorProperties() {
+      register_property(
+           m_pin_threads, "pin_threads",
+           "Whether the threads of the executor are pinned to cores.");
+      register_property(
+           m_fma_scale, "fma_scale",
+           "Factor applied to the fma of the synthetic kernels.");
+   }
+
+   bool m_pin_threads {true};
+   double m_fma_scale {1.0};
+};
+
+class Executor {
+ public:
+   explicit Executor(Callbacks callbacks, const bool pin_threads = true)
+        : m_callbacks(std::move(callbacks)), m_pin_threads(pin_threads) {}
+
+   //! Runs a scheduled sequence with one thread per scheduled thread. Each
+   //! thread runs its operations in the order of their start times and
+   //! waits for the operands of each operation. Rethrows the first
+   //! exception of a callback once all threads are done.
+   inline auto run(const Sequence& sequence) -> Report {
+      if (!sequence.is_scheduled()) {
+         throw std::invalid_argument("The sequence has to be scheduled.");
+      }
+
+      const std::size_t length = sequence.length();
+      std::size_t threads = 0;
+      for (const Operation& op : sequence) {
+         threads = std::max(threads, op.thread + 1);
+      }
+
+      // Operations per thread in the order of their start times
+      std::vector<std::vector<std::size_t>> queues(threads);
+      for (std::size_t op_idx = 0; op_idx < length; ++op_idx) {
+         queues[sequence[op_idx].thread].push_back(op_idx);
+      }
+      for (std::vector<std::size_t>& queue : queues) {
+         std::ranges::stable_sort(
+              queue, {}, [&sequence](const std::size_t op_idx) noexcept {
+                 return sequence[op_idx].start_time;
+              });
+      }
+
+      std::vector<std::vector<std::size_t>> children(length);
+      for (std::size_t op_idx = 0; op_idx < length; ++op_idx) {
+         children[op_idx] = sequence.children(op_idx);
+      }
+
+      Report report;
+      report.timings.resize(length);
+      const std::unique_ptr<std::atomic<bool>[]> done =
+           std::make_unique<std::atomic<bool>[]>(length);
+      std::exception_ptr error;
+      std::mutex error_mutex;
+      std::latch ready(static_cast<std::ptrdiff_t>(threads) + 1);
+      std::chrono::steady_clock::time_point start_time;
+
+      auto work = [&](const std::size_t thread) -> void {
+         ready.arrive_and_wait();
+         for (const std::size_t op_idx : queues[thread]) {
+            for (const std::size_t child_idx : children[op_idx]) {
+               done[child_idx].wait(false);
+            }
+
+            const double start = elapsed(start_time);
+            try {
+               evaluate(sequence[op_idx]);
+            } catch (...) {
+               std::lock_guard<std::mutex> lock(error_mutex);
+               if (!error) {
+                  error = std::current_exception();
+               }
+            }
+            report.timings[op_idx] = {start, elapsed(start_time)};
+
+            // Waiting operations continue even after an error
+            done[op_idx].store(true);
+            done[op_idx].notify_all();
+         }
+      };
+
+      {
+         std::vector<std::jthread> pool;
+         for (std::size_t t = 0; t < threads; ++t) {
+            pool.emplace_back(work, t);
+            if (m_pin_threads) {
+               pin(pool.back(), t);
+            }
+         }
+         start_time = std::chrono::steady_clock::now();
+         ready.arrive_and_wait();
+      }
+
+      if (error) {
+         std::rethrow_exception(error);
+      }
+
+      std::size_t fma = 0;
+      double busy_time = 0.0;
+      for (std::size_t op_idx = 0; op_idx < length; ++op_idx) {
+         const Operation& op = sequence[op_idx];
+         fma += op.fma;
+         report.predicted_makespan = std::max(
+              report.predicted_makespan, op.start_time + op.fma);
+         busy_time += report.timings[op_idx].end -
+                      report.timings[op_idx].start;
+         report.makespan = std::max(
+              report.makespan, report.timings[op_idx].end);
+      }
+      if (fma > 0) {
+         report.seconds_per_fma = busy_time / static_cast<double>(fma);
+      }
+
+      return report;
+   }
+
+ private:
+   Callbacks m_callbacks;
+   bool m_pin_threads;
+
+   inline auto evaluate(const Operation& op) const -> void {
+      const Callback& callback = (op.action == Action::MULTIPLICATION)
+                                      ? m_callbacks.multiplication
+                                 : (op.mode == Mode::TANGENT)
+                                      ? m_callbacks.tangent
+                                      : m_callbacks.adjoint;
+      if (callback) {
+         callback(op);
+      }
+   }
+
+   inline static auto elapsed(
+        const std::chrono::steady_clock::time_point start) -> double {
+      return std::chrono::duration<double>(
+                  std::chrono::steady_clock::now() - start)
+           .count();
+   }
+
+   //! Pins a thread to a core (round robin). Only available on Linux,
+   //! elsewhere the threads float.
+   inline static auto pin(std::jthread& thread, const std::size_t idx)
+        -> void {
+#if defined(__linux__)
+      const std::size_t cores = std::max(
+           std::thread::hardware_concurrency(), 1u);
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      CPU_SET(idx % cores, &cpus);
+      pthread_setaffinity_np(
+           thread.native_handle(), sizeof(cpu_set_t), &cpus);
+#else
+      static_cast<void>(thread);
+      static_cast<void>(idx);
+#endif
+   }
+};
+
+}  // namespace jcdp::executor
+
+#endif  // JCDP_EXECUTOR_EXECUTOR_HPP_
@@ -0,0 +1,99 @@
+/******************************************************************************
+ * @file jcdp/executor/kernels.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides synthetic kernels
+ *        for the executor that perform as many fma as the cost model predicts
+ *        on buffers sized like the Jacobians of the chain.
+ ******************************************************************************/
+
+#ifndef JCDP_EXECUTOR_KERNELS_HPP_
+#define JCDP_EXECUTOR_KERNELS_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "jcdp/executor/executor.hpp"
+#include "jcdp/jacobian.hpp"
+#include "jcdp/jacobian_chain.hpp"
+#include "jcdp/operation.hpp"
+#include "jcdp/sequence.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::executor {
+
+class SyntheticKernels {
+ public:
+   //! Allocates one dense buffer per Jacobian the sequence produces. Every
+   //! operation performs its fma (times fma_scale) on its output buffer and
+   //! the buffers of its operands. The elementals an elimination propagates
+   //! through and the tape of adjoint operations are not stored.
+   SyntheticKernels(
+        const JacobianChain& chain, const Sequence& sequence,
+        const double fma_scale = 1.0)
+       : m_fma_scale(fma_scale) {
+      for (const Operation& op : sequence) {
+         const Jacobian& jac = chain.get_jacobian(op.j, op.i);
+         const std::size_t size = std::max(jac.m * jac.n, std::size_t {1});
+         m_buffers[{op.j, op.i}].assign(size, 1.0);
+      }
+   }
+
+   //! The callbacks refer to this object, so it has to outlive the run.
+   inline auto callbacks() -> Callbacks {
+      Callback kernel = [this](const Operation& op) -> void {
+         run(op);
+      };
+      return {kernel, kernel, kernel};
+   }
+
+ private:
+   double m_fma_scale;
+   std::map<std::pair<std::size_t, std::size_t>, std::vector<double>>
+        m_buffers {};
+
+   inline auto run(const Operation& op) -> void {
+      std::vector<double>& out = m_buffers.at({op.j, op.i});
+      const std::vector<double>& lhs = operand(op.j, op.k + 1, op, out);
+      const std::vector<double>& rhs = operand(op.k, op.i, op, out);
+
+      const std::size_t fma = static_cast<std::size_t>(
+           std::llround(m_fma_scale * static_cast<double>(op.fma)));
+      std::size_t o = 0, l = 0, r = 0;
+      for (std::size_t f = 0; f < fma; ++f) {
+         out[o] += lhs[l] * rhs[r];
+         if (++o == out.size()) {
+            o = 0;
+         }
+         if (++l == lhs.size()) {
+            l = 0;
+         }
+         if (++r == rhs.size()) {
+            r = 0;
+         }
+      }
+   }
+
+   //! Buffer of an operand. Accumulations and operands that are not
+   //! accumulated (e.g. the elementals of an elimination) use the output.
+   inline auto operand(
+        const std::size_t j, const std::size_t i, const Operation& op,
+        const std::vector<double>& out) const -> const std::vector<double>& {
+      if (op.action == Action::ACCUMULATION) {
+         return out;
+      }
+
+      const auto it = m_buffers.find({j, i});
+      return (it != m_buffers.end()) ? it->second : out;
+   }
+};
+
+}  // namespace jcdp::executor
+
+#endif  // JCDP_EXECUTOR_KERNELS_HPP_
@@ -13,6 +13,8 @@
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <limits>
+#include <optional>
 #include <vector>
 
 #include "jcdp/jacobian.hpp"
@@ -28,6 +30,14 @@ struct JacobianChain {
    std::vector<std::size_t> optimized_costs {};
    std::size_t id {0};
 
+   //! Frontier of the elimination: The accumulated sub-chains that weren't
+   //! used yet are disjoint. For every elemental, the last (first) elemental
+   //! of the one that starts (ends) there or NONE. Kept up to date by apply
+   //! and revert.
+   static constexpr std::size_t NONE = std::numeric_limits<std::size_t>::max();
+   std::vector<std::size_t> frontier_ends {};
+   std::vector<std::size_t> frontier_starts {};
+
    inline auto length() const -> std::size_t {
       return elemental_jacobians.size();
    }
@@ -35,28 +45,76 @@ struct JacobianChain {
    inline auto init_subchains() -> void {
       const std::size_t len = length();
       sub_chains.resize(len * (len - 1) / 2);
+      update_subchains(0, len - 1);
+      frontier_ends.assign(len, NONE);
+      frontier_starts.assign(len, NONE);
+   }
 
-      for (std::size_t j = 0; j < len; ++j) {
-         for (std::size_t i = 0; i < j; ++i) {
+   //! Recomputes all sub-chains that contain at least one of the elemental
+   //! Jacobians first, ..., last. Has to be called after the sizes or costs
+   //! of these elementals changed.
+   inline auto update_subchains(const std::size_t first, const std::size_t last)
+        -> void {
+      const std::size_t len = length();
+      for (std::size_t j = std::max<std::size_t>(first, 1); j < len; ++j) {
+         for (std::size_t i = 0; i < j && i <= last; ++i) {
             const std::size_t idx = j * (j - 1) / 2 + i;
 
-            sub_chains[idx].i = elemental_jacobians[i].i;
-            sub_chains[idx].j = elemental_jacobians[j].j;
-            sub_chains[idx].n = elemental_jacobians[i].n;
-            sub_chains[idx].m = elemental_jacobians[j].m;
-
-            for (std::size_t k = i; k <= j; ++k) {
-               sub_chains[idx].edges_in_dag +=
-                    elemental_jacobians[k].edges_in_dag;
-               sub_chains[idx].tangent_cost +=
-                    elemental_jacobians[k].tangent_cost;
-               sub_chains[idx].adjoint_cost +=
-                    elemental_jacobians[k].adjoint_cost;
-            }
+            // Sub-chain (j - 1, i) is either unaffected or was already
+            // updated in the previous iteration over j.
+            const Jacobian& prev = get_jacobian(j - 1, i);
+            const Jacobian& elemental = elemental_jacobians[j];
+
+            // The chain (and its storage) may be reused for another chain,
+            // therefore reset the sub-chain completely.
+            sub_chains[idx] = Jacobian {
+                 .i = elemental_jacobians[i].i,
+                 .j = elemental.j,
+                 .n = elemental_jacobians[i].n,
+                 .m = elemental.m,
+                 .edges_in_dag = prev.edges_in_dag + elemental.edges_in_dag,
+                 .tangent_cost = prev.tangent_cost + elemental.tangent_cost,
+                 .adjoint_cost = prev.adjoint_cost + elemental.adjoint_cost};
          }
       }
    }
 
+   //! Appends an elemental Jacobian to the end of the chain and adds the new
+   //! sub-chains (q - 1, i). All existing sub-chains remain untouched.
+   inline auto append(const Jacobian& jac) -> void {
+      const std::size_t len = length();
+      assert(len == 0 || elemental_jacobians.back().m == jac.n);
+
+      elemental_jacobians.push_back(jac);
+      elemental_jacobians.back().i = len;
+      elemental_jacobians.back().j = len + 1;
+
+      sub_chains.resize((len + 1) * len / 2);
+      update_subchains(len, len);
+      frontier_ends.resize(len + 1, NONE);
+      frontier_starts.resize(len + 1, NONE);
+   }
+
+   //! Last elemental of the accumulated, unused sub-chain that starts at
+   //! elemental i (if any) in O(1).
+   inline auto frontier_end(const std::size_t i) const
+        -> std::optional<std::size_t> {
+      if (frontier_ends[i] == NONE) {
+         return {};
+      }
+      return frontier_ends[i];
+   }
+
+   //! First elemental of the accumulated, unused sub-chain that ends at
+   //! elemental j (if any) in O(1).
+   inline auto frontier_start(const std::size_t j) const
+        -> std::optional<std::size_t> {
+      if (frontier_starts[j] == NONE) {
+         return {};
+      }
+      return frontier_starts[j];
+   }
+
    inline auto apply(const Operation& op) -> bool {
       Jacobian& ij_jac = get_jacobian(op.j, op.i);
       if (ij_jac.is_accumulated) {
@@ -75,6 +133,7 @@ struct JacobianChain {
                }
                jk_jac.is_accumulated = true;
                ki_jac.is_used = true;
+               remove_from_frontier(op.k, op.i);
             } break;
 
             case Mode::ADJOINT: {
@@ -84,6 +143,7 @@ struct JacobianChain {
                }
                ki_jac.is_accumulated = true;
                jk_jac.is_used = true;
+               remove_from_frontier(op.j, op.k + 1);
             } break;
 
             case Mode::NONE: {
@@ -93,6 +153,8 @@ struct JacobianChain {
                }
                jk_jac.is_used = true;
                ki_jac.is_used = true;
+               remove_from_frontier(op.j, op.k + 1);
+               remove_from_frontier(op.k, op.i);
             } break;
 
             default: {
@@ -102,6 +164,7 @@ struct JacobianChain {
       }
 
       ij_jac.is_accumulated = true;
+      add_to_frontier(op.j, op.i);
       return true;
    }
 
@@ -109,6 +172,7 @@ struct JacobianChain {
       Jacobian& ij_jac = get_jacobian(op.j, op.i);
       assert(ij_jac.is_accumulated);
       ij_jac.is_accumulated = false;
+      remove_from_frontier(op.j, op.i);
 
       if (op.action != Action::ACCUMULATION) {
          Jacobian& jk_jac = get_jacobian(op.j, op.k + 1);
@@ -118,12 +182,14 @@ struct JacobianChain {
             jk_jac.is_accumulated = false;
          } else {
             jk_jac.is_used = false;
+            add_to_frontier(op.j, op.k + 1);
          }
 
          if (op.mode == Mode::ADJOINT) {
             ki_jac.is_accumulated = false;
          } else {
             ki_jac.is_used = false;
+            add_to_frontier(op.k, op.i);
          }
       }
    }
@@ -150,6 +216,19 @@ struct JacobianChain {
    }
 
  private:
+   inline auto add_to_frontier(const std::size_t j, const std::size_t i)
+        -> void {
+      frontier_ends[i] = j;
+      frontier_starts[j] = i;
+   }
+
+   inline auto remove_from_frontier(const std::size_t j, const std::size_t i)
+        -> void {
+      assert(frontier_ends[i] == j && frontier_starts[j] == i);
+      frontier_ends[i] = NONE;
+      frontier_starts[j] = NONE;
+   }
+
    template<typename Self>
    inline static auto get_jacobian_impl(
         Self& self, const std::size_t j, const std::size_t i)
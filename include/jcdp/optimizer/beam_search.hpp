@@ -0,0 +1,423 @@
+/******************************************************************************
+ * @file jcdp/optimizer/beam_search.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides an optimizer that
+ *        builds elimination sequences operation by operation like the branch
+ *        & bound optimizer, but only keeps the most promising partial
+ *        sequences of every level (beam search).
+ ******************************************************************************/
+
+#ifndef JCDP_OPTIMIZER_BEAM_SEARCH_HPP_
+#define JCDP_OPTIMIZER_BEAM_SEARCH_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <print>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "jcdp/jacobian.hpp"
+#include "jcdp/jacobian_chain.hpp"
+#include "jcdp/operation.hpp"
+#include "jcdp/optimizer/optimizer.hpp"
+#include "jcdp/scheduler/priority_list.hpp"
+#include "jcdp/scheduler/scheduler.hpp"
+#include "jcdp/sequence.hpp"
+#include "jcdp/util/cancellation_token.hpp"
+#include "jcdp/util/improvement.hpp"
+#include "jcdp/util/timer.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::optimizer {
+
+/******************************************************************************
+ * @brief Beam search over the elimination tree of the branch & bound
+ *        optimizer.
+ *
+ * Level l of the search holds partial sequences with l operations. Every
+ * partial sequence of the beam is expanded by all operations the branch &
+ * bound optimizer would try next (first the accumulations, then the
+ * eliminations and multiplications). Complete sequences are scheduled with
+ * the given scheduler, all others are scored and only the beam_width best
+ * ones are kept for the next level. The cost is linear in the beam width
+ * and in the length of the longest possible sequence.
+ *
+ * The score of a partial sequence is its makespan after list scheduling,
+ * raised to an estimate for the makespan of every completion: the earliest
+ * end time of the whole chain and the total fma divided by the amount of
+ * threads, both via a DP over the remaining chain. Partial sequences that
+ * can't be completed or can't improve the incumbent are dropped.
+ ******************************************************************************/
+class BeamSearchOptimizer : public Optimizer,
+                            public util::Timer,
+                            public util::ImprovementNotifier {
+ public:
+   BeamSearchOptimizer() : Optimizer() {
+      register_property(
+           m_time_to_solve, "time_to_solve",
+           "Maximal runtime for the beam search in seconds.");
+      register_property(
+           m_beam_width, "beam_width",
+           "Amount of partial sequences that the beam search keeps per "
+           "level.");
+   }
+
+   virtual ~BeamSearchOptimizer() = default;
+
+   auto init(
+        const JacobianChain& chain,
+        const std::shared_ptr<scheduler::Scheduler>& sched) -> void {
+      Optimizer::init(chain);
+
+      m_scheduler = sched;
+      m_optimal_sequence.assign_max();
+      m_makespan = m_optimal_sequence.makespan();
+      m_timer_expired = false;
+
+      m_levels = 0;
+      m_expanded = 0;
+      m_leafs = 0;
+   }
+
+   virtual auto solve() -> Sequence override final {
+      start_timer();
+
+      std::vector<State> beam(1);
+      beam[0].chain = *m_chain;
+
+      std::vector<std::vector<State>> children;
+      std::vector<State> candidates;
+      while (!beam.empty() && !m_token.is_cancelled()) {
+         m_levels++;
+         m_expanded += beam.size();
+         children.resize(beam.size());
+
+         // Snapshot, so the pruning doesn't depend on the timing (unless
+         // the incumbent is shared with other solvers)
+         const std::size_t makespan = std::min(m_makespan, shared_makespan());
+         std::vector<Sequence> leafs(beam.size(), Sequence::make_max());
+
+         #pragma omp parallel for schedule(dynamic, 1)
+         for (std::size_t s = 0; s < beam.size(); ++s) {
+            children[s].clear();
+            if (poll()) {
+               expand(beam[s], children[s]);
+               evaluate(children[s], makespan, leafs[s]);
+            }
+         }
+
+         // Merge in the order of the beam, so the result is independent of
+         // the amount of threads.
+         candidates.clear();
+         for (std::size_t s = 0; s < beam.size(); ++s) {
+            if (leafs[s].makespan() < m_makespan) {
+               m_optimal_sequence = leafs[s];
+               m_makespan = leafs[s].makespan();
+               notify_improvement({
+                    .makespan = m_makespan,
+                    .threads = m_usable_threads,
+                    .elapsed_time = elapsed_time()});
+            }
+
+            for (State& child : children[s]) {
+               if (child.lower_bound < std::min(m_makespan, makespan)) {
+                  candidates.push_back(std::move(child));
+               }
+            }
+         }
+
+         const std::size_t width = std::min(
+              std::max<std::size_t>(m_beam_width, 1), candidates.size());
+         std::stable_sort(
+              candidates.begin(), candidates.end(),
+              [](const State& lhs, const State& rhs) -> bool {
+                 return std::tie(lhs.score, lhs.total_fma) <
+                        std::tie(rhs.score, rhs.total_fma);
+              });
+         candidates.resize(width);
+         std::swap(beam, candidates);
+      }
+
+      m_timer_expired |= m_token.is_cancelled();
+      return m_optimal_sequence;
+   }
+
+   //! Seeds the incumbent with a complete, scheduled sequence. Partial
+   //! sequences that can't improve it are dropped from the beam.
+   inline auto set_incumbent(const Sequence& sequence) -> void {
+      m_optimal_sequence = sequence;
+      m_makespan = m_optimal_sequence.makespan();
+   }
+
+   inline auto print_stats() -> void {
+      std::println("Levels: {}", m_levels);
+      std::println("Partial sequences expanded: {}", m_expanded);
+      std::println("Leafs visited (= sequences scheduled): {}", m_leafs);
+   }
+
+ private:
+   std::size_t m_beam_width {64};
+
+   //! Partial sequence of the beam and its state in the elimination tree.
+   struct State {
+      Sequence sequence {};
+      JacobianChain chain {};
+      std::vector<OpPair> eliminations {};
+      std::size_t elim_idx {0};
+
+      // Accumulations are performed in ascending order of the elementals
+      std::size_t next_accumulation {0};
+      bool is_eliminating {false};
+
+      // Estimate for the makespan of every completion and the score that
+      // ranks the partial sequences of a level.
+      std::size_t lower_bound {0};
+      std::size_t score {0};
+
+      // Lower bound for the total fma of every completion
+      std::size_t total_fma {0};
+   };
+
+   Sequence m_optimal_sequence {Sequence::make_max()};
+   std::size_t m_makespan {std::numeric_limits<std::size_t>::max()};
+   std::shared_ptr<scheduler::Scheduler> m_scheduler;
+   scheduler::PriorityListScheduler m_list_scheduler {};
+
+   std::size_t m_levels {0};
+   std::size_t m_expanded {0};
+   std::size_t m_leafs {0};
+
+   using Optimizer::init;
+
+   //! Appends all states that extend the given state by one operation.
+   inline auto expand(const State& state, std::vector<State>& children)
+        -> void {
+      if (!state.is_eliminating) {
+         for (std::size_t j = state.next_accumulation; j < m_length; ++j) {
+            State& child = children.emplace_back(state);
+            const Operation op = cheapest_accumulation(j);
+            child.chain.apply(op);
+            push_possible_eliminations(
+                 child.chain, child.eliminations, op.j, op.i);
+            child.sequence.push_back(op);
+            child.next_accumulation = j + 1;
+         }
+
+         // Without matrix-free eliminations, all elementals are accumulated
+         const std::size_t min_accs = m_matrix_free ? 1 : m_length;
+         if (state.sequence.length() < min_accs) {
+            return;
+         }
+      }
+
+      for (std::size_t idx = state.elim_idx; idx < state.eliminations.size();
+           ++idx) {
+         for (std::size_t pair_idx = 0; pair_idx <= 1; ++pair_idx) {
+            if (!state.eliminations[idx][pair_idx].has_value()) {
+               continue;
+            }
+
+            const Operation op = state.eliminations[idx][pair_idx].value();
+            State& child = children.emplace_back(state);
+            if (!child.chain.apply(op)) {
+               children.pop_back();
+               continue;
+            }
+
+            push_possible_eliminations(
+                 child.chain, child.eliminations, op.j, op.i);
+            child.sequence.push_back(op);
+            child.elim_idx = idx + 1;
+            child.is_eliminating = true;
+         }
+      }
+   }
+
+   //! Scores the children of a state. Complete sequences are scheduled and
+   //! the best one is kept as leaf, they aren't expanded any further.
+   inline auto evaluate(
+        std::vector<State>& children, const std::size_t makespan,
+        Sequence& leaf) -> void {
+      util::CancellationToken token(&m_token);
+      token.start();
+
+      std::size_t kept = 0;
+      for (State& child : children) {
+         const std::size_t fma = child.sequence.sequential_makespan();
+         if (child.chain.get_jacobian(m_length - 1, 0).is_accumulated) {
+            const std::size_t lb = lower_bound(
+                 child.sequence.critical_path(), fma);
+            const std::size_t upper_bound = std::min(
+                 makespan, leaf.makespan());
+            if (lb < upper_bound) {
+               const std::size_t leaf_makespan = m_scheduler->schedule(
+                    child.sequence, m_usable_threads, makespan, token);
+
+               #pragma omp atomic
+               m_leafs++;
+
+               // The scheduler may give up above its upper bound and leave
+               // the sequence unscheduled.
+               if (leaf_makespan < upper_bound &&
+                   child.sequence.is_scheduled()) {
+                  leaf = child.sequence;
+               }
+            }
+            continue;
+         }
+
+         m_list_scheduler.schedule(
+              child.sequence, m_usable_threads,
+              std::numeric_limits<std::size_t>::max(), token);
+         const Completion completion = complete(child);
+         if (completion.fma == std::numeric_limits<std::size_t>::max()) {
+            continue;
+         }
+         child.total_fma = fma + completion.fma;
+         child.lower_bound = std::max(
+              completion.end_time,
+              lower_bound(child.sequence.critical_path(), child.total_fma));
+         child.score = std::max(child.sequence.makespan(), child.lower_bound);
+
+         if (kept != static_cast<std::size_t>(&child - children.data())) {
+            children[kept] = std::move(child);
+         }
+         kept++;
+      }
+      children.resize(kept);
+   }
+
+   //! Total fma and earliest end time of a (partial) completion.
+   struct Completion {
+      std::size_t fma {std::numeric_limits<std::size_t>::max()};
+      std::size_t end_time {std::numeric_limits<std::size_t>::max()};
+   };
+
+   //! Minimal total fma and earliest end time of every completion of the
+   //! state, both computed via the DP of the chain where the accumulated,
+   //! unused sub-chains of the state are leaves that end with their list
+   //! schedule. Elementals in between may only be accumulated while the
+   //! state is still accumulating. The end times ignore the amount of
+   //! threads.
+   inline auto complete(const State& state) -> Completion {
+      constexpr std::size_t inf = std::numeric_limits<std::size_t>::max();
+      const JacobianChain& chain = state.chain;
+
+      // Split the chain into accumulated sub-chains and single elementals
+      std::vector<std::pair<std::size_t, std::size_t>> units;
+      std::vector<bool> is_block;
+      for (std::size_t i = 0; i < m_length;) {
+         std::size_t j = m_length - 1;
+         while (j > i && !(chain.get_jacobian(j, i).is_accumulated &&
+                           !chain.get_jacobian(j, i).is_used)) {
+            --j;
+         }
+         const Jacobian& jac = chain.get_jacobian(j, i);
+         units.emplace_back(j, i);
+         is_block.push_back(jac.is_accumulated && !jac.is_used);
+         i = j + 1;
+      }
+
+      const std::size_t len = units.size();
+      auto add = [](const std::size_t lhs, const std::size_t rhs)
+           -> std::size_t {
+         return (lhs == inf || rhs == inf) ? inf : lhs + rhs;
+      };
+
+      // table[b * len + a]: cheapest way to accumulate units a, ..., b
+      std::vector<Completion> table(len * len);
+      for (std::size_t u = 0; u < len; ++u) {
+         Completion& leaf = table[u * len + u];
+         if (is_block[u]) {
+            leaf.fma = 0;
+            leaf.end_time = 0;
+            for (const Operation& op : state.sequence) {
+               if (op.j == units[u].first && op.i == units[u].second) {
+                  leaf.end_time = op.start_time + op.fma;
+               }
+            }
+         } else if (!state.is_eliminating &&
+                    units[u].second >= state.next_accumulation) {
+            leaf.fma = cheapest_accumulation(units[u].second).fma;
+            leaf.end_time = leaf.fma;
+         }
+      }
+
+      auto relax = [](Completion& node, const std::size_t fma,
+                      const std::size_t end_time) -> void {
+         node.fma = std::min(node.fma, fma);
+         node.end_time = std::min(node.end_time, end_time);
+      };
+
+      for (std::size_t width = 1; width < len; ++width) {
+         for (std::size_t a = 0; a + width < len; ++a) {
+            const std::size_t b = a + width;
+            const std::size_t j = units[b].first;
+            const std::size_t i = units[a].second;
+            Completion& node = table[b * len + a];
+
+            bool lhs_is_free = true;
+            for (std::size_t s = b; s-- > a;) {
+               lhs_is_free &= !is_block[s + 1];
+               const std::size_t k = units[s].first;
+               const Completion& lhs = table[b * len + s + 1];
+               const Completion& rhs = table[s * len + a];
+
+               const std::size_t mul = m_chain->elemental_jacobians[j].m *
+                                       m_chain->elemental_jacobians[k].m *
+                                       m_chain->elemental_jacobians[i].n;
+               relax(
+                    node, add(add(lhs.fma, rhs.fma), mul),
+                    add(std::max(lhs.end_time, rhs.end_time), mul));
+
+               if (!m_matrix_free) {
+                  continue;
+               }
+               if (lhs_is_free) {
+                  const std::size_t tan = m_chain->get_jacobian(j, k + 1)
+                                               .fma<Mode::TANGENT>(
+                                                    m_chain->elemental_jacobians
+                                                         [i].n);
+                  relax(node, add(rhs.fma, tan), add(rhs.end_time, tan));
+               }
+
+               const bool rhs_is_free = std::none_of(
+                    is_block.cbegin() + a, is_block.cbegin() + s + 1,
+                    [](const bool block) -> bool {
+                       return block;
+                    });
+               const Jacobian& ki_jac = m_chain->get_jacobian(k, i);
+               if (rhs_is_free &&
+                   (m_available_memory == 0 ||
+                    m_available_memory >= ki_jac.edges_in_dag)) {
+                  const std::size_t adj = ki_jac.fma<Mode::ADJOINT>(
+                       m_chain->elemental_jacobians[j].m);
+                  relax(node, add(lhs.fma, adj), add(lhs.end_time, adj));
+               }
+            }
+         }
+      }
+
+      return table[(len - 1) * len];
+   }
+
+   inline auto lower_bound(
+        const std::size_t critical_path, const std::size_t fma) const
+        -> std::size_t {
+      if (m_usable_threads == 0) {
+         return critical_path;
+      }
+      return std::max(
+           critical_path, (fma + m_usable_threads - 1) / m_usable_threads);
+   }
+};
+
+}  // end namespace jcdp::optimizer
+
+#endif  // JCDP_OPTIMIZER_BEAM_SEARCH_HPP_
@@ -11,14 +11,31 @@
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
+#if defined(__linux__)
+#include <pthread.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <cerrno>
 #include <chrono>
 #include <cstddef>
+#include <deque>
+#include <functional>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <optional>
 #include <print>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -28,20 +45,57 @@
 #include "jcdp/optimizer/optimizer.hpp"
 #include "jcdp/scheduler/scheduler.hpp"
 #include "jcdp/sequence.hpp"
+#include "jcdp/util/cancellation_token.hpp"
+#include "jcdp/util/improvement.hpp"
+#include "jcdp/util/shared_memory.hpp"
 #include "jcdp/util/timer.hpp"
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
 namespace jcdp::optimizer {
 
-class BranchAndBoundOptimizer : public Optimizer, public util::Timer {
-   using OpPair = std::array<std::optional<Operation>, 2>;
-
+class BranchAndBoundOptimizer : public Optimizer,
+                                public util::Timer,
+                                public util::ImprovementNotifier {
  public:
    BranchAndBoundOptimizer() : Optimizer() {
       register_property(
            m_time_to_solve, "time_to_solve",
            "Maximal runtime for the branch & bound solver in seconds.");
+      register_property(
+           m_node_budget, "node_budget",
+           "Maximal amount of nodes visited by the branch & bound solver "
+           "(0 = unlimited). Applies per work unit in deterministic mode.");
+      register_property(
+           m_deterministic, "deterministic",
+           "Makes the result independent of the amount of OpenMP threads and "
+           "their timing. The time limit is only checked between waves of "
+           "work units.");
+      register_property(
+           m_processes, "processes",
+           "Amount of worker processes that share the search via shared "
+           "memory (Linux only, not combined with deterministic mode).");
+      register_property(
+           m_dominance_pruning, "dominance_pruning",
+           "Prunes partial sequences that reach the same state of the chain "
+           "as an earlier one, but with a larger total fma and later "
+           "accumulated sub-chains. Only applied if the search is for one or "
+           "for unlimited threads, where it is exact (not in deterministic or "
+           "multi-process mode).");
+      register_property(
+           m_dominance_store_size, "dominance_store_size",
+           "Amount of states remembered for the dominance pruning.");
+      register_property(
+           m_schedule_cache_size, "schedule_cache_size",
+           "Amount of scheduled leaf sequences remembered to skip sequences "
+           "with the same operations (0 = disabled, not in deterministic "
+           "mode).");
+      register_property(
+           m_move_ordering, "move_ordering",
+           "Order in which the operations of a node are tried after the ones "
+           "of the guide: stack, fma (cheapest first), critical_path "
+           "(earliest end first) or history (most often part of an "
+           "improved incumbent first).");
    }
 
    virtual ~BranchAndBoundOptimizer() = default;
@@ -52,37 +106,143 @@ class BranchAndBoundOptimizer : public Optimizer, public util::Timer {
       Optimizer::init(chain);
 
       m_scheduler = sched;
-      m_optimal_sequence = Sequence::make_max();
-      m_makespan = m_optimal_sequence.makespan();
-      m_upper_bound = m_makespan;
+      for (std::size_t t = 0; t < m_optimal_sequences.size(); ++t) {
+         m_optimal_sequences[t].assign_max();
+         m_makespans[t] = m_optimal_sequences[t].makespan();
+         m_upper_bounds[t] = m_makespans[t];
+         m_lower_bounds[t] = 0;
+      }
+      m_upper_bound = std::numeric_limits<std::size_t>::max();
+      m_lower_bound = 0;
       m_timer_expired = false;
 
+      m_ordering = parse_move_ordering(m_move_ordering);
+      m_guided_moves.clear();
+      m_guide_accumulations = 0;
+      m_history.assign(
+           (m_ordering == MoveOrdering::HISTORY) ? 3 * m_length * m_length *
+                                                        m_length
+                                                 : 0,
+           0);
+
+      init_look_ahead();
+      m_dominance_store.clear();
+      if (m_dominance_pruning) {
+         m_dominance_store.resize(std::max<std::size_t>(
+              m_dominance_store_size, 1));
+      }
+      m_dominated_branches = 0;
+      m_schedule_cache_hits = 0;
+
       m_leafs = 0;
       m_updated_makespan = 0;
-      m_pruned_branches.clear();
-      m_pruned_branches.resize(m_chain.longest_possible_sequence() + 1);
+      m_pruned_branches.assign(m_chain->longest_possible_sequence() + 1, 0);
    }
 
    virtual auto solve() -> Sequence override final {
+      search(m_usable_threads, m_usable_threads);
+      return m_optimal_sequences[m_usable_threads];
+   }
 
-      set_timer(m_time_to_solve);
-      start_timer();
-      std::size_t accs = m_matrix_free ? 0 : (m_length - 1);
+   //! Solves the chain for all thread counts 1, ..., m_usable_threads in a
+   //! single traversal of the elimination tree. Every leaf is scheduled once
+   //! per thread count and every thread count keeps its own incumbent and
+   //! bounds. A branch is only pruned if it can't improve any of them.
+   //! Returns the optimal sequence for t threads at index t - 1.
+   auto solve_front() -> std::vector<Sequence> {
+      const std::size_t first = std::min<std::size_t>(m_usable_threads, 1);
+      search(first, m_usable_threads);
+      return std::vector<Sequence>(
+           m_optimal_sequences.cbegin() + first,
+           m_optimal_sequences.cbegin() + m_usable_threads + 1);
+   }
 
-      #pragma omp parallel default(shared)
-      #pragma omp single
-      while (++accs <= m_length) {
-         Sequence sequence {};
-         std::vector<OpPair> eliminations {};
-         JacobianChain chain = m_chain;
-         add_accumulation(sequence, chain, accs, eliminations);
+   //! Sets an upper bound for the makespan. Without a thread count, the
+   //! bound applies to all thread counts.
+   inline auto set_upper_bound(
+        const std::size_t upper_bound,
+        const std::optional<std::size_t> threads = {}) -> void {
+      if (threads.has_value()) {
+         reserve_threads(threads.value());
+         m_upper_bounds[threads.value()] = upper_bound;
+      } else {
+         m_upper_bound = upper_bound;
+      }
+   }
+
+   //! Sets a proven lower bound for the makespan, e.g. derived from the DP
+   //! solutions. It is only reported along with improvements of the
+   //! incumbent. Without a thread count, the bound applies to all thread
+   //! counts.
+   inline auto set_lower_bound(
+        const std::size_t lower_bound,
+        const std::optional<std::size_t> threads = {}) -> void {
+      if (threads.has_value()) {
+         reserve_threads(threads.value());
+         m_lower_bounds[threads.value()] = lower_bound;
+      } else {
+         m_lower_bound = lower_bound;
       }
+   }
+
+   //! Seeds the incumbent with a complete, scheduled sequence, e.g. a DP
+   //! sequence after list scheduling. Without a thread count, the sequence
+   //! is used for m_usable_threads.
+   inline auto set_incumbent(
+        const Sequence& sequence,
+        const std::optional<std::size_t> threads = {}) -> void {
+      const std::size_t t = threads.value_or(m_usable_threads);
+      assert(sequence.is_scheduled());
 
-      return m_optimal_sequence;
+      reserve_threads(t);
+      m_optimal_sequences[t] = sequence;
+      m_makespans[t] = m_optimal_sequences[t].makespan();
    }
 
-   inline auto set_upper_bound(const std::size_t upper_bound) {
-      m_upper_bound = upper_bound;
+   //! Sets a guide sequence (e.g. the DP solution) whose choices are explored
+   //! first: its amount of accumulations, its accumulated Jacobians and then
+   //! the eliminations and multiplications that agree with its bracketing.
+   //! Only changes the search order, not the search space. The maximum
+   //! sequence (e.g. a guide that doesn't fit into memory) guides nothing.
+   inline auto set_guide(const Sequence& guide) -> void {
+      const std::size_t len = m_length;
+      m_guided_moves.assign(3 * len * len * len, false);
+
+      for (const Operation& op : guide) {
+         switch (op.action) {
+            case Action::ACCUMULATION:
+            case Action::MULTIPLICATION: {
+               m_guided_moves[move_index(op)] = true;
+            } break;
+
+            // The guide may sweep over multiple elementals at once, the
+            // branch & bound optimizer only over one at a time.
+            case Action::ELIMINATION: {
+               Operation step = op;
+               if (op.mode == Mode::TANGENT) {
+                  for (step.k = op.k; step.k < op.j; ++step.k) {
+                     step.j = step.k + 1;
+                     m_guided_moves[move_index(step)] = true;
+                  }
+               } else {
+                  for (step.k = op.i; step.k <= op.k; ++step.k) {
+                     step.i = step.k;
+                     m_guided_moves[move_index(step)] = true;
+                  }
+               }
+            } break;
+
+            case Action::NONE: {
+               // Only the maximum sequence consists of such an operation
+            } break;
+
+            default: {
+               assert(false);
+            }
+         }
+      }
+
+      m_guide_accumulations = guide.count_accumulations();
    }
 
    inline auto print_stats() -> void {
@@ -97,12 +257,153 @@ class BranchAndBoundOptimizer : public Optimizer, public util::Timer {
          std::print("{} ", pruned);
       }
       std::println("]");
+      std::println("Dominated branches: {}", m_dominated_branches);
+      std::println("Schedule cache hits: {}", m_schedule_cache_hits);
    }
 
  private:
-   Sequence m_optimal_sequence {Sequence::make_max()};
-   std::size_t m_makespan {m_optimal_sequence.makespan()};
-   std::size_t m_upper_bound {m_makespan};
+   // Incumbents and bounds, indexed by the amount of threads
+   std::vector<Sequence> m_optimal_sequences {};
+   std::vector<std::size_t> m_makespans {};
+   std::vector<std::size_t> m_upper_bounds {};
+   std::vector<std::size_t> m_lower_bounds {};
+   std::size_t m_lower_bound {0};
+   std::size_t m_upper_bound {std::numeric_limits<std::size_t>::max()};
+
+   // Range of thread counts that are solved for in the current traversal
+   std::size_t m_first_threads {0};
+   std::size_t m_last_threads {0};
+
+   //! Independent part of the search in deterministic mode: All elimination
+   //! sequences that extend a fixed prefix. Is searched sequentially against
+   //! its own incumbents, starting from a snapshot of the global ones.
+   struct WorkUnit {
+      Sequence sequence {};
+      JacobianChain chain {};
+      std::vector<OpPair> eliminations {};
+      std::size_t elim_idx {0};
+
+      // Incumbents found by this unit (empty if none), by amount of threads
+      std::vector<Sequence> optimal_sequences {};
+      std::vector<std::size_t> makespans {};
+      util::CancellationToken token {};
+   };
+
+   //! Amount of eliminations that are performed before a work unit is split
+   //! off, and amount of work units that are searched before the incumbents
+   //! are merged. Both are independent of the amount of threads.
+   static constexpr std::size_t WORK_UNIT_DEPTH = 2;
+   static constexpr std::size_t WAVE_SIZE = 64;
+
+   bool m_deterministic {false};
+   std::deque<WorkUnit> m_work_units {};
+   std::size_t m_work_unit_length {0};
+
+   //! State shared by all worker processes in multi-process mode. Lives at
+   //! the start of the shared memory and is followed by the pruning counters
+   //! and one SharedIncumbent (plus its operations) per amount of threads.
+   struct SharedState {
+      std::atomic<std::size_t> next_work_unit {0};
+      std::atomic<std::size_t> leafs {0};
+      std::atomic<std::size_t> updated_makespan {0};
+      std::atomic<bool> timer_expired {false};
+#if defined(__linux__)
+      //! Guards the incumbents. Robust, so a worker that dies while holding
+      //! it doesn't block the others.
+      pthread_mutex_t lock {};
+#endif
+   };
+
+   struct SharedIncumbent {
+      std::atomic<std::size_t> makespan {0};
+      std::size_t length {0};
+      double elapsed_time {0};
+   };
+
+   static_assert(std::atomic<std::size_t>::is_always_lock_free);
+
+   //! Interval in which the parent process merges the incumbents of the
+   //! workers.
+   static constexpr std::chrono::milliseconds SHARED_POLL_INTERVAL {10};
+
+   std::size_t m_processes {1};
+
+   // Only set in worker processes
+   SharedState* m_shared {nullptr};
+   std::size_t m_work_unit_counter {0};
+   std::size_t m_claimed_work_unit {0};
+#if defined(__linux__)
+   const util::SharedMemory* m_shared_memory {nullptr};
+#endif
+
+   // Look-ahead costs of the missing operations, per elemental for its
+   // elimination or its cheaper processing
+   std::vector<std::size_t> m_elimination_fma {};
+   std::vector<std::size_t> m_processing_fma {};
+   std::size_t m_total_elimination_fma {0};
+   std::size_t m_total_processing_fma {0};
+   std::size_t m_multiplication_fma {0};
+   std::size_t m_final_fma {0};
+
+   //! State of the chain reached by a partial sequence: the accumulated,
+   //! unused sub-chains and the operations that may still be performed, plus
+   //! the costs of the partial sequence. Partial sequences with the same key
+   //! have exactly the same completions.
+   struct DominanceEntry {
+      std::vector<std::size_t> key {};
+      std::size_t fma {0};
+
+      // Earliest end time of each accumulated sub-chain in the key
+      std::vector<std::size_t> end_times {};
+   };
+
+   // Bounded store of visited states, indexed by the hash of their key. A
+   // slot keeps the most recent state that isn't dominated. The slots are
+   // guarded by striped locks, slot s by lock s % DOMINANCE_LOCKS.
+   static constexpr std::size_t DOMINANCE_LOCKS = 64;
+   bool m_dominance_pruning {false};
+   std::size_t m_dominance_store_size {1 << 16};
+   std::vector<DominanceEntry> m_dominance_store {};
+   std::array<std::mutex, DOMINANCE_LOCKS> m_dominance_locks {};
+   std::size_t m_dominated_branches {0};
+
+   //! Leaf sequence that was scheduled for an amount of threads. The key is
+   //! the canonical form of its tree of operations and their fma, which is
+   //! all the schedulers depend on. Different sequences (e.g. of chains with
+   //! repeated elementals) may share a key.
+   struct ScheduleCacheEntry {
+      std::vector<std::size_t> key {};
+      std::size_t threads {0};
+      std::size_t makespan {0};
+   };
+
+   // Bounded store of scheduled leafs of the current traversal, indexed by
+   // the hash of their key and the amount of threads
+   std::size_t m_schedule_cache_size {1 << 14};
+   std::vector<ScheduleCacheEntry> m_schedule_cache {};
+   std::size_t m_schedule_cache_hits {0};
+
+   // Search order derived from the guide sequence, indexed by move_index
+   std::vector<bool> m_guided_moves {};
+   std::size_t m_guide_accumulations {0};
+
+   enum class MoveOrdering { STACK, FMA, CRITICAL_PATH, HISTORY };
+
+   //! Candidate operation of a node with its position in the search order.
+   struct Move {
+      bool is_guided {false};
+      std::size_t rank {0};
+      std::size_t idx {0};
+      std::size_t pair_idx {0};
+   };
+
+   std::string m_move_ordering {"stack"};
+   MoveOrdering m_ordering {MoveOrdering::STACK};
+   std::vector<std::size_t> m_accumulation_order {};
+
+   // How often every move was part of an improved incumbent
+   std::vector<std::size_t> m_history {};
+
    std::size_t m_leafs {0};
    std::vector<std::size_t> m_pruned_branches {};
    std::size_t m_updated_makespan {0};
@@ -110,12 +411,539 @@ class BranchAndBoundOptimizer : public Optimizer, public util::Timer {
 
    using Optimizer::init;
 
+   inline auto reserve_threads(const std::size_t threads) -> void {
+      if (m_optimal_sequences.size() <= threads) {
+         m_optimal_sequences.resize(threads + 1, Sequence::make_max());
+         m_makespans.resize(
+              threads + 1, std::numeric_limits<std::size_t>::max());
+         m_upper_bounds.resize(
+              threads + 1, std::numeric_limits<std::size_t>::max());
+         m_lower_bounds.resize(threads + 1, 0);
+      }
+   }
+
+   inline auto search(const std::size_t first, const std::size_t last)
+        -> void {
+      reserve_threads(last);
+      m_first_threads = first;
+      m_last_threads = last;
+
+      // Cached makespans are only compared against the incumbents of the
+      // same traversal. The results of a work unit depend on ties, which a
+      // cache hit would hide. Memory limits and transfer costs depend on
+      // more than the shape of the tree, so they rule out the cache as well.
+      m_schedule_cache.clear();
+      if (!m_deterministic && !m_scheduler->is_memory_aware() &&
+          !m_scheduler->is_communication_aware()) {
+         m_schedule_cache.resize(m_schedule_cache_size);
+      }
+
+#if defined(__linux__)
+      if (m_processes > 1 && !m_deterministic) {
+         search_in_processes();
+         return;
+      }
+#endif
+
+      traverse();
+   }
+
+   //! Traverses the whole search tree. In a worker process, the work units
+   //! of other workers are skipped.
+   inline auto traverse() -> void {
+      m_timer_expired = false;
+      if (m_deterministic) {
+         // Only an external cancellation may stop the work units
+         m_token.start();
+      } else {
+         start_timer();
+      }
+      const std::size_t min_accs = m_matrix_free ? 1 : m_length;
+      const std::size_t first_accs = std::clamp(
+           m_guide_accumulations, min_accs, m_length);
+
+      auto search_accumulations = [this](const std::size_t accs) -> void {
+         m_work_unit_length = accs + WORK_UNIT_DEPTH;
+         order_accumulations();
+         Sequence sequence {};
+         std::vector<OpPair> eliminations {};
+         JacobianChain chain = *m_chain;
+         add_accumulation(sequence, chain, accs, eliminations);
+      };
+
+      // The OpenMP thread pool of the parent isn't usable after fork()
+      #pragma omp parallel default(shared) if (m_shared == nullptr)
+      #pragma omp single
+      {
+         // Start with the amount of accumulations of the guide (if any)
+         search_accumulations(first_accs);
+         for (std::size_t accs = min_accs; accs <= m_length; ++accs) {
+            if (accs != first_accs) {
+               search_accumulations(accs);
+            }
+         }
+
+         if (m_deterministic) {
+            run_work_units();
+         }
+      }
+   }
+
+   //! Lower bound for the makespan of every sequence that extends a
+   //! (partial) sequence with the given critical path and total fma when
+   //! scheduled on t threads (t = 0 means unlimited threads).
+   inline static auto lower_bound(
+        const std::size_t critical_path, const std::size_t sequential_makespan,
+        const std::size_t t) -> std::size_t {
+      if (t == 0) {
+         return critical_path;
+      }
+      return std::max(critical_path, (sequential_makespan + t - 1) / t);
+   }
+
+   //! Makespan a sequence for t threads has to beat. The shared incumbent
+   //! only counts for m_usable_threads and not in deterministic mode, where
+   //! it would make the result depend on the timing of other solvers.
+   inline auto incumbent_makespan(
+        const std::vector<std::size_t>& makespans, const std::size_t t) const
+        -> std::size_t {
+      if (t != m_usable_threads || m_deterministic) {
+         return makespans[t];
+      }
+      return std::min(makespans[t], shared_makespan());
+   }
+
+   //! Checks critical path and total fma as lower bounds for every thread
+   //! count. Returns false if the partial sequence can't improve any of the
+   //! incumbents. In deterministic mode, branches that may only tie are kept
+   //! as well. Both bounds look ahead at the operations that are still
+   //! missing (see remaining_fma), the critical path by the final operation
+   //! which depends on all others.
+   inline auto may_improve(
+        Sequence& sequence, const std::vector<std::size_t>& makespans,
+        const bool is_eliminating) const -> bool {
+      const std::size_t critical_path = sequence.critical_path() +
+                                        m_final_fma;
+      const std::size_t sequential_makespan = sequence.sequential_makespan() +
+                                              remaining_fma(
+                                                   sequence, is_eliminating);
+      for (std::size_t t = m_first_threads; t <= m_last_threads; ++t) {
+         const std::size_t lb = lower_bound(
+              critical_path, sequential_makespan, t);
+         const std::size_t incumbent = incumbent_makespan(makespans, t);
+         const bool beats_incumbent = m_deterministic ? lb <= incumbent
+                                                      : lb < incumbent;
+         if (beats_incumbent &&
+             lb <= std::min(m_upper_bound, m_upper_bounds[t])) {
+            return true;
+         }
+      }
+      return false;
+   }
+
+   //! Earliest start of an operation that follows the first `length`
+   //! operations of a sequence with unlimited threads, i.e. the end time of
+   //! the latest operations that produced its operands.
+   inline static auto earliest_start_time(
+        const Sequence& sequence, const std::vector<std::size_t>& end_times,
+        const std::size_t length, const Operation& op) -> std::size_t {
+      auto end_time_of = [&](const std::size_t j,
+                             const std::size_t i) -> std::size_t {
+         for (std::size_t p = length; p-- > 0;) {
+            if (sequence[p].j == j && sequence[p].i == i) {
+               return end_times[p];
+            }
+         }
+         return 0;
+      };
+
+      std::size_t start_time = 0;
+      if (op.action == Action::MULTIPLICATION ||
+          (op.action == Action::ELIMINATION && op.mode == Mode::ADJOINT)) {
+         start_time = end_time_of(op.j, op.k + 1);
+      }
+      if (op.action == Action::MULTIPLICATION ||
+          (op.action == Action::ELIMINATION && op.mode == Mode::TANGENT)) {
+         start_time = std::max(start_time, end_time_of(op.k, op.i));
+      }
+      return start_time;
+   }
+
+   //! Earliest end time of every operation of a sequence with unlimited
+   //! threads. The operands of an operation are produced before it.
+   inline static auto earliest_end_times(const Sequence& sequence)
+        -> std::vector<std::size_t> {
+      std::vector<std::size_t> end_times(sequence.length(), 0);
+      for (std::size_t idx = 0; idx < sequence.length(); ++idx) {
+         end_times[idx] = earliest_start_time(
+                               sequence, end_times, idx, sequence[idx]) +
+                          sequence[idx].fma;
+      }
+      return end_times;
+   }
+
+   //! Looks up the state reached by a partial sequence in the dominance
+   //! store. Returns true if an earlier partial sequence reached the same
+   //! state with a total fma and end times of all accumulated sub-chains
+   //! that are at most as large. The completions of the earlier one are
+   //! then at least as good, which is exact for a single and for unlimited
+   //! threads only. Otherwise, the state is stored.
+   inline auto is_dominated(
+        Sequence& sequence, const JacobianChain& chain,
+        const std::vector<OpPair>& eliminations, const std::size_t elim_idx)
+        -> bool {
+      DominanceEntry entry {.fma = sequence.sequential_makespan()};
+      const std::vector<std::size_t> end_times = earliest_end_times(sequence);
+
+      std::vector<std::pair<std::size_t, std::size_t>> blocks;
+      for (std::size_t idx = 0; idx < sequence.length(); ++idx) {
+         const Operation& op = sequence[idx];
+         const Jacobian& jac = chain.get_jacobian(op.j, op.i);
+         if (jac.is_accumulated && !jac.is_used) {
+            blocks.emplace_back(op.i, idx);
+         }
+      }
+
+      std::sort(blocks.begin(), blocks.end());
+      for (const auto& [i, idx] : blocks) {
+         entry.key.push_back(sequence[idx].j * m_length + i);
+         entry.end_times.push_back(end_times[idx]);
+      }
+
+      // Operations that may still be performed, in the order of the search
+      const std::size_t none = std::numeric_limits<std::size_t>::max();
+      entry.key.push_back(none);
+      for (std::size_t idx = elim_idx; idx < eliminations.size(); ++idx) {
+         for (const std::optional<Operation>& op : eliminations[idx]) {
+            entry.key.push_back(op.has_value() ? move_index(op.value()) : none);
+         }
+      }
+
+      const std::size_t slot_idx = hash_key(entry.key) %
+                                   m_dominance_store.size();
+      std::lock_guard<std::mutex> lock(
+           m_dominance_locks[slot_idx % DOMINANCE_LOCKS]);
+
+      DominanceEntry& slot = m_dominance_store[slot_idx];
+      if (slot.key == entry.key && slot.fma <= entry.fma &&
+          std::equal(
+               slot.end_times.cbegin(), slot.end_times.cend(),
+               entry.end_times.cbegin(),
+               [](const std::size_t lhs, const std::size_t rhs) -> bool {
+                  return lhs <= rhs;
+               })) {
+         return true;
+      }
+
+      slot = std::move(entry);
+      return false;
+   }
+
+   inline static auto parse_move_ordering(const std::string& ordering)
+        -> MoveOrdering {
+      if (ordering == "stack") {
+         return MoveOrdering::STACK;
+      }
+      if (ordering == "fma") {
+         return MoveOrdering::FMA;
+      }
+      if (ordering == "critical_path") {
+         return MoveOrdering::CRITICAL_PATH;
+      }
+      if (ordering == "history") {
+         return MoveOrdering::HISTORY;
+      }
+      throw std::invalid_argument("Unknown move ordering: " + ordering);
+   }
+
+   //! Position of an operation in the move ordering, smaller ranks first.
+   //! The start time is only used for the critical path ordering.
+   inline auto move_rank(const Operation& op, const std::size_t start_time)
+        const -> std::size_t {
+      switch (m_ordering) {
+         case MoveOrdering::FMA: {
+            return op.fma;
+         }
+
+         case MoveOrdering::CRITICAL_PATH: {
+            return start_time + op.fma;
+         }
+
+         case MoveOrdering::HISTORY: {
+            std::size_t count;
+            #pragma omp atomic read
+            count = m_history[move_index(op)];
+            return std::numeric_limits<std::size_t>::max() - count;
+         }
+
+         default: {
+            return 0;
+         }
+      }
+   }
+
+   //! Orders the elementals for the enumeration of the accumulated subsets:
+   //! the accumulations of the guide first, then by the move ordering. Must
+   //! not be called while subsets are enumerated.
+   inline auto order_accumulations() -> void {
+      std::vector<Move> moves(m_length);
+      for (std::size_t j = 0; j < m_length; ++j) {
+         const Operation op = cheapest_accumulation(j);
+         moves[j] = Move {
+              .is_guided = !m_guided_moves.empty() &&
+                           m_guided_moves[move_index(op)],
+              .rank = move_rank(op, 0),
+              .idx = j};
+      }
+      std::ranges::stable_sort(moves, is_tried_before);
+
+      m_accumulation_order.clear();
+      for (const Move& move : moves) {
+         m_accumulation_order.push_back(move.idx);
+      }
+   }
+
+   inline static auto is_tried_before(const Move& lhs, const Move& rhs)
+        -> bool {
+      return std::tie(rhs.is_guided, lhs.rank) <
+             std::tie(lhs.is_guided, rhs.rank);
+   }
+
+   //! Rewards every move of an improved incumbent for the history ordering.
+   //! Worker processes don't learn, since each of them would learn from
+   //! its own incumbents and enumerate different work units.
+   inline auto learn_moves(const Sequence& sequence) -> void {
+      if (m_history.empty() || m_shared != nullptr) {
+         return;
+      }
+      for (const Operation& op : sequence) {
+         std::size_t& count = m_history[move_index(op)];
+
+         #pragma omp atomic
+         count++;
+      }
+   }
+
+   inline static auto hash_key(const std::vector<std::size_t>& key)
+        -> std::size_t {
+      std::size_t hash = key.size();
+      for (const std::size_t value : key) {
+         hash ^= std::hash<std::size_t> {}(value) + 0x9e3779b97f4a7c15 +
+                 (hash << 6) + (hash >> 2);
+      }
+      return hash;
+   }
+
+   //! Canonical form of the sub-tree of the operation at op_idx: its fma
+   //! followed by the canonical forms of its children in sorted order,
+   //! enclosed in brackets.
+   inline static auto schedule_cache_key(
+        const Sequence& sequence, const std::size_t op_idx)
+        -> std::vector<std::size_t> {
+      constexpr std::size_t open = std::numeric_limits<std::size_t>::max();
+      constexpr std::size_t close = open - 1;
+
+      std::vector<std::vector<std::size_t>> children;
+      for (const std::size_t child_idx : sequence.children(op_idx)) {
+         children.push_back(schedule_cache_key(sequence, child_idx));
+      }
+      std::ranges::sort(children);
+
+      std::vector<std::size_t> key {open, sequence[op_idx].fma};
+      for (const std::vector<std::size_t>& child : children) {
+         key.insert(key.end(), child.cbegin(), child.cend());
+      }
+      key.push_back(close);
+      return key;
+   }
+
+   //! Key of a complete leaf sequence in the schedule cache.
+   inline static auto schedule_cache_key(const Sequence& sequence)
+        -> std::vector<std::size_t> {
+      for (std::size_t op_idx = 0; op_idx < sequence.length(); ++op_idx) {
+         if (!sequence.parent(op_idx).has_value()) {
+            return schedule_cache_key(sequence, op_idx);
+         }
+      }
+      return {};
+   }
+
+   inline auto schedule_cache_slot(
+        const std::vector<std::size_t>& key, const std::size_t threads)
+        -> ScheduleCacheEntry& {
+      const std::size_t hash = hash_key(key) ^ (threads * 0x9e3779b97f4a7c15);
+      return m_schedule_cache[hash % m_schedule_cache.size()];
+   }
+
+   //! Returns true if a sequence with the same tree was already scheduled
+   //! for t threads in this traversal and its makespan doesn't beat the
+   //! given incumbent. Scheduling the tree again can't improve the
+   //! incumbent then (up to ties that a heuristic scheduler may break
+   //! differently).
+   inline auto is_cached(
+        const std::vector<std::size_t>& key, const std::size_t threads,
+        const std::size_t incumbent) -> bool {
+      bool is_cached = false;
+      #pragma omp critical(jcdp_schedule_cache)
+      {
+         const ScheduleCacheEntry& slot = schedule_cache_slot(key, threads);
+         is_cached = slot.threads == threads && slot.key == key &&
+                     slot.makespan >= incumbent;
+      }
+      return is_cached;
+   }
+
+   inline auto cache_schedule(
+        std::vector<std::size_t> key, const std::size_t threads,
+        const std::size_t makespan) -> void {
+      #pragma omp critical(jcdp_schedule_cache)
+      {
+         ScheduleCacheEntry& slot = schedule_cache_slot(key, threads);
+         slot = ScheduleCacheEntry {
+              .key = std::move(key), .threads = threads, .makespan = makespan};
+      }
+   }
+
+   //! Counts a pruned branch of the given length.
+   inline auto prune(const std::size_t length) -> void {
+      std::size_t& prune_counter = m_pruned_branches[length];
+
+      #pragma omp atomic
+      prune_counter++;
+   }
+
+   //! Derives the look-ahead costs once per chain. Every elemental is either
+   //! accumulated or eliminated exactly once. An elimination evaluates the
+   //! elemental at least with the smallest n to its right (tangent) or the
+   //! smallest m to its left (adjoint). Every accumulation but one is
+   //! followed by a multiplication, and the final operation (j = q - 1,
+   //! i = 0) is a multiplication or an elimination of the first or last
+   //! elemental.
+   inline auto init_look_ahead() -> void {
+      constexpr std::size_t inf = std::numeric_limits<std::size_t>::max();
+      const std::vector<Jacobian>& elementals = m_chain->elemental_jacobians;
+
+      std::vector<std::size_t> min_m(m_length + 1, inf);
+      for (std::size_t j = m_length; j-- > 0;) {
+         min_m[j] = std::min(min_m[j + 1], elementals[j].m);
+      }
+
+      m_elimination_fma.assign(m_length, inf);
+      m_processing_fma.assign(m_length, inf);
+      m_total_elimination_fma = 0;
+      m_total_processing_fma = 0;
+      m_multiplication_fma = inf;
+      m_final_fma = inf;
+
+      std::size_t min_n = inf;
+      for (std::size_t e = 0; e < m_length; ++e) {
+         const Jacobian& jac = elementals[e];
+         const bool adjoint_fits = m_available_memory == 0 ||
+                                   m_available_memory >= jac.edges_in_dag;
+
+         std::size_t& elimination_fma = m_elimination_fma[e];
+         if (m_matrix_free && e > 0) {
+            elimination_fma = jac.fma<Mode::TANGENT>(min_n);
+         }
+         if (m_matrix_free && e + 1 < m_length && adjoint_fits) {
+            elimination_fma = std::min(
+                 elimination_fma, jac.fma<Mode::ADJOINT>(min_m[e + 1]));
+         }
+
+         // If the elemental can't be eliminated, it has to be accumulated
+         const std::size_t accumulation_fma = cheapest_accumulation(e).fma;
+         m_processing_fma[e] = std::min(accumulation_fma, elimination_fma);
+         if (elimination_fma == inf) {
+            elimination_fma = accumulation_fma;
+         }
+         m_total_elimination_fma += elimination_fma;
+         m_total_processing_fma += m_processing_fma[e];
+
+         min_n = std::min(min_n, jac.n);
+         if (e + 1 < m_length) {
+            m_multiplication_fma = std::min(
+                 m_multiplication_fma, jac.m * min_m[e + 1] * min_n);
+            m_final_fma = std::min(
+                 m_final_fma,
+                 elementals.back().m * jac.m * elementals.front().n);
+         }
+      }
+
+      if (m_length > 1 && m_matrix_free) {
+         m_final_fma = std::min(
+              m_final_fma,
+              elementals.back().fma<Mode::TANGENT>(elementals.front().n));
+         if (m_available_memory == 0 ||
+             m_available_memory >= elementals.front().edges_in_dag) {
+            m_final_fma = std::min(
+                 m_final_fma,
+                 elementals.front().fma<Mode::ADJOINT>(elementals.back().m));
+         }
+      }
+
+      if (m_length <= 1) {
+         m_multiplication_fma = 0;
+         m_final_fma = 0;
+      }
+   }
+
+   //! Lower bound for the total fma of the operations that are still missing
+   //! to accumulate the whole chain: the elementals that weren't accumulated
+   //! or eliminated yet (once all accumulations are chosen, they can only be
+   //! eliminated) and the missing multiplications.
+   inline auto remaining_fma(
+        const Sequence& sequence, const bool is_eliminating) const
+        -> std::size_t {
+      const std::vector<std::size_t>& elemental_fma =
+           is_eliminating ? m_elimination_fma : m_processing_fma;
+      std::size_t fma = is_eliminating ? m_total_elimination_fma
+                                       : m_total_processing_fma;
+      std::size_t accumulations = 0;
+      std::size_t multiplications = 0;
+      for (const Operation& op : sequence) {
+         switch (op.action) {
+            case Action::ACCUMULATION: {
+               fma -= elemental_fma[op.j];
+               accumulations++;
+            } break;
+
+            case Action::MULTIPLICATION: {
+               multiplications++;
+            } break;
+
+            case Action::ELIMINATION: {
+               fma -= elemental_fma[(op.mode == Mode::TANGENT) ? op.j : op.i];
+            } break;
+
+            default: {
+               assert(false);
+            }
+         }
+      }
+
+      // Without matrix-free eliminations, every elemental is accumulated
+      if (!is_eliminating && !m_matrix_free) {
+         accumulations = m_length;
+      }
+      if (accumulations > multiplications + 1) {
+         fma += (accumulations - multiplications - 1) * m_multiplication_fma;
+      }
+      return fma;
+   }
+
    inline auto add_accumulation(
         Sequence& sequence, JacobianChain& chain, const std::size_t accs,
-        std::vector<OpPair>& eliminations, std::size_t j = 0) -> void {
+        std::vector<OpPair>& eliminations, std::size_t pos = 0) -> void {
+      // The amount of accumulated subsets grows exponentially with the
+      // length of the chain, so stop the enumeration with the solve.
+      if (m_token.is_cancelled()) {
+         return;
+      }
+
       if (accs > 0) {
-         for (; j < m_chain.length(); ++j) {
-            const Operation op = cheapest_accumulation(j);
+         for (; pos < m_accumulation_order.size(); ++pos) {
+            const Operation op = cheapest_accumulation(
+                 m_accumulation_order[pos]);
             if (!chain.apply(op)) {
                continue;
             }
@@ -123,12 +951,23 @@ class BranchAndBoundOptimizer : public Optimizer, public util::Timer {
             push_possible_eliminations(chain, eliminations, op.j, op.i);
             sequence.push_back(std::move(op));
 
-            add_accumulation(sequence, chain, accs - 1, eliminations, j + 1);
+            // Prune the subsets of accumulations early (but not before the
+            // split of worker processes)
+            if (m_shared == nullptr &&
+                !may_improve(sequence, m_makespans, false)) {
+               prune(sequence.length());
+            } else {
+               add_accumulation(
+                    sequence, chain, accs - 1, eliminations, pos + 1);
+            }
 
             sequence.pop_back();
             eliminations.pop_back();
             chain.revert(op);
          }
+      } else if (m_deterministic || m_shared != nullptr) {
+         // Work units are split off in a fixed order by a single thread
+         add_elimination(sequence, chain, eliminations);
       } else {
          // Copies for spawned task (Necessary on Windows)
          Sequence task_sequence = sequence;
@@ -143,195 +982,577 @@ class BranchAndBoundOptimizer : public Optimizer, public util::Timer {
 
    inline auto add_elimination(
         Sequence& sequence, JacobianChain& chain,
-        std::vector<OpPair>& eliminations, std::size_t elim_idx = 0) -> void {
+        std::vector<OpPair>& eliminations, std::size_t elim_idx = 0,
+        WorkUnit* unit = nullptr) -> void {
 
-      // Return if time's up
-      if (!remaining_time()) {
+      // Return if time's up, the node budget is exhausted or the solve was
+      // cancelled
+      if (!(unit ? unit->token.poll() : poll())) {
          return;
       }
 
+      const bool is_accumulated =
+           chain.get_jacobian(chain.length() - 1, 0).is_accumulated;
+
+      // In deterministic and multi-process mode, the first levels only split
+      // the search into work units. Deterministic mode searches them in
+      // waves, a worker process only the ones it claims.
+      const bool is_splitting = (m_deterministic || m_shared != nullptr) &&
+                                unit == nullptr &&
+                                sequence.length() < m_work_unit_length;
+      if ((m_deterministic || m_shared != nullptr) && unit == nullptr &&
+          (is_splitting ? is_accumulated
+                        : sequence.length() == m_work_unit_length)) {
+         if (m_deterministic) {
+            add_work_unit(sequence, chain, eliminations, elim_idx);
+            return;
+         }
+         if (!claim_work_unit()) {
+            return;
+         }
+      }
+
       // Check if we accumulated the entire jacobian
-      if (chain.get_jacobian(chain.length() - 1, 0).is_accumulated) {
+      if (is_accumulated) {
          assert(elim_idx == eliminations.size() - 1);
          assert(!eliminations[elim_idx][0].has_value());
          assert(!eliminations[elim_idx][1].has_value());
 
-         // Start new task for the scheduling of the final sequence. If
+         if (unit != nullptr) {
+            schedule_in_work_unit(sequence, *unit);
+            return;
+         }
+
+         const std::size_t critical_path = sequence.critical_path();
+         const std::size_t sequential_makespan = sequence.sequential_makespan();
+         std::vector<std::size_t> key {};
+         if (!m_schedule_cache.empty()) {
+            key = schedule_cache_key(sequence);
+         }
+
+         // Start new tasks for the scheduling of the final sequence. If
          // branch & bound is used as the scheduling algorithm, this can take
          // some time.
+         for (std::size_t t = m_first_threads; t <= m_last_threads; ++t) {
+            const std::size_t incumbent = incumbent_makespan(m_makespans, t);
+            if (lower_bound(critical_path, sequential_makespan, t) >=
+                incumbent) {
+               continue;
+            }
 
-         // Copies for spawned task (Necessary on Windows)
-         Sequence final_sequence = sequence;
-         const std::shared_ptr<scheduler::Scheduler> scheduler = m_scheduler;
+            if (!key.empty() && is_cached(key, t, incumbent)) {
+               #pragma omp atomic
+               m_schedule_cache_hits++;
+
+               continue;
+            }
 
-         #pragma omp task default(shared) \
-                          firstprivate(final_sequence, scheduler)
-         {
-            const double time_to_schedule = remaining_time();
-            if (time_to_schedule) {
-               scheduler->set_timer(time_to_schedule);
+            // Copies for spawned task (Necessary on Windows)
+            Sequence final_sequence = sequence;
+            const std::shared_ptr<scheduler::Scheduler> scheduler =
+                 m_scheduler;
 
-               const std::size_t new_makespan = scheduler->schedule(
-                    final_sequence, m_usable_threads, m_makespan);
+            #pragma omp task default(shared) \
+                             firstprivate(final_sequence, scheduler, t, key)
+            {
+               // The scheduler stops with the optimizer
+               util::CancellationToken leaf_token(&m_token);
+               leaf_token.start();
 
-               m_timer_expired |= !scheduler->finished_in_time();
+               if (!leaf_token.is_cancelled()) {
+                  // The schedule is only valid if it beats the upper bound
+                  const std::size_t upper_bound = incumbent_makespan(
+                       m_makespans, t);
+                  const std::size_t new_makespan = scheduler->schedule(
+                       final_sequence, t, upper_bound, leaf_token);
 
-               #pragma omp atomic
-               m_leafs++;
+                  if (leaf_token.is_cancelled()) {
+                     #pragma omp atomic write
+                     m_timer_expired = true;
+                  } else if (!key.empty()) {
+                     cache_schedule(std::move(key), t, new_makespan);
+                  }
+
+                  #pragma omp atomic
+                  m_leafs++;
+
+                  #pragma omp critical
+                  {
+                     if (m_shared != nullptr) {
+                        pull_shared_incumbents();
+                     }
 
-               #pragma omp critical
-               if (m_makespan > new_makespan) {
-                  m_optimal_sequence = final_sequence;
-                  m_makespan = new_makespan;
-                  m_updated_makespan++;
+                     if (new_makespan < upper_bound &&
+                         m_makespans[t] > new_makespan) {
+                        m_optimal_sequences[t] = final_sequence;
+                        m_makespans[t] = new_makespan;
+                        m_updated_makespan++;
+                        learn_moves(final_sequence);
+
+                        if (m_shared != nullptr) {
+                           push_shared_incumbent(t);
+                        } else {
+                           notify_improvement({
+                                .makespan = new_makespan,
+                                .lower_bound = std::max(
+                                     m_lower_bound, m_lower_bounds[t]),
+                                .threads = t,
+                                .elapsed_time = elapsed_time()});
+                        }
+                     }
+                  }
                }
             }
          }
          return;
       }
 
-      // Check critical path as lower bound
-      const std::size_t lower_bound = sequence.critical_path();
-      if (lower_bound >= m_makespan || lower_bound > m_upper_bound) {
-         std::size_t& prune_counter = m_pruned_branches[sequence.length()];
+      // Worker processes must not prune before the split, otherwise they
+      // would enumerate different work units.
+      const bool is_promising = (is_splitting && m_shared != nullptr) ||
+                                may_improve(
+                                     sequence,
+                                     unit ? unit->makespans : m_makespans,
+                                     true);
 
+      if (!is_promising) {
+         prune(sequence.length());
+         return;
+      }
+
+      // Results would depend on the timing of the tasks in deterministic
+      // mode and the store isn't shared between processes. For 2, 3, ...
+      // threads, the dominance could prune the optimum, and so could memory
+      // limits and transfer costs, as they aren't part of the comparison.
+      if (!m_dominance_store.empty() && !m_deterministic &&
+          m_shared == nullptr && m_last_threads <= 1 &&
+          !m_scheduler->is_memory_aware() &&
+          !m_scheduler->is_communication_aware() &&
+          is_dominated(sequence, chain, eliminations, elim_idx)) {
          #pragma omp atomic
-         prune_counter++;
+         m_dominated_branches++;
 
          return;
       }
 
-      // Perform all possible elimination from the current elim_idx
-      for (; elim_idx < eliminations.size(); ++elim_idx) {
+      // Perform all possible elimination from the current elim_idx. The
+      // operations that agree with the guide are performed first, then the
+      // move ordering decides. Only changes the order of the children.
+      std::vector<std::size_t> end_times {};
+      if (m_ordering == MoveOrdering::CRITICAL_PATH) {
+         end_times = earliest_end_times(sequence);
+      }
+
+      std::vector<Move> moves {};
+      for (std::size_t idx = elim_idx; idx < eliminations.size(); ++idx) {
          for (std::size_t pair_idx = 0; pair_idx <= 1; ++pair_idx) {
-            if (!eliminations[elim_idx][pair_idx].has_value()) {
+            if (!eliminations[idx][pair_idx].has_value()) {
                continue;
             }
 
-            const Operation op = eliminations[elim_idx][pair_idx].value();
-            if (!chain.apply(op)) {
-               continue;
+            const Operation& op = eliminations[idx][pair_idx].value();
+            const std::size_t start_time =
+                 end_times.empty() ? 0
+                                   : earliest_start_time(
+                                          sequence, end_times,
+                                          sequence.length(), op);
+            moves.push_back(Move {
+                 .is_guided = !m_guided_moves.empty() &&
+                              m_guided_moves[move_index(op)],
+                 .rank = move_rank(op, start_time),
+                 .idx = idx,
+                 .pair_idx = pair_idx});
+         }
+      }
+      std::ranges::stable_sort(moves, is_tried_before);
+
+      for (const Move& move : moves) {
+         const Operation op = eliminations[move.idx][move.pair_idx].value();
+         if (!chain.apply(op)) {
+            continue;
+         }
+
+         push_possible_eliminations(chain, eliminations, op.j, op.i);
+         sequence.push_back(op);
+
+         add_elimination(sequence, chain, eliminations, move.idx + 1, unit);
+
+         sequence.pop_back();
+         eliminations.pop_back();
+         chain.revert(op);
+      }
+   }
+
+   //! Stores the current state as a new work unit. Searches the pending
+   //! work units once a wave is full.
+   inline auto add_work_unit(
+        const Sequence& sequence, const JacobianChain& chain,
+        const std::vector<OpPair>& eliminations, const std::size_t elim_idx)
+        -> void {
+      WorkUnit& unit = m_work_units.emplace_back();
+      unit.sequence = sequence;
+      unit.chain = chain;
+      unit.eliminations = eliminations;
+      unit.elim_idx = elim_idx;
+      unit.optimal_sequences.resize(m_last_threads + 1);
+      unit.makespans.resize(m_last_threads + 1);
+
+      if (m_work_units.size() >= WAVE_SIZE) {
+         run_work_units();
+      }
+   }
+
+   //! Searches all pending work units in parallel against a snapshot of the
+   //! incumbents and merges their results in a fixed order afterwards. The
+   //! units only stop at their node budget, which is reproducible. If the
+   //! search is cancelled meanwhile, the whole wave is discarded.
+   inline auto run_work_units() -> void {
+      // Stops the remaining enumeration of work units as well
+      if (m_time_to_solve >= 0 && elapsed_time() >= m_time_to_solve) {
+         m_token.cancel();
+      }
+
+      if (!m_token.is_cancelled()) {
+         for (WorkUnit& unit : m_work_units) {
+            WorkUnit* task_unit = &unit;
+
+            #pragma omp task default(shared) firstprivate(task_unit)
+            {
+               std::copy_n(
+                    m_makespans.begin(), m_last_threads + 1,
+                    task_unit->makespans.begin());
+               // The deadline is only checked between waves
+               task_unit->token.set_parent(&m_token);
+               task_unit->token.start(-1, m_node_budget, false);
+
+               add_elimination(
+                    task_unit->sequence, task_unit->chain,
+                    task_unit->eliminations, task_unit->elim_idx, task_unit);
             }
+         }
 
-            push_possible_eliminations(chain, eliminations, op.j, op.i);
-            sequence.push_back(op);
+         #pragma omp taskwait
 
-            add_elimination(sequence, chain, eliminations, elim_idx + 1);
+         // Which units finished before the cancellation depends on timing
+         if (m_token.is_cancelled()) {
+            m_timer_expired = true;
+            m_work_units.clear();
+            return;
+         }
 
-            sequence.pop_back();
-            eliminations.pop_back();
-            chain.revert(op);
+         for (WorkUnit& unit : m_work_units) {
+            m_timer_expired |= unit.token.is_cancelled();
+
+            for (std::size_t t = m_first_threads; t <= m_last_threads; ++t) {
+               const Sequence& found = unit.optimal_sequences[t];
+               if (found.empty() || unit.makespans[t] > m_makespans[t] ||
+                   (unit.makespans[t] == m_makespans[t] &&
+                    !canonical_less(found, m_optimal_sequences[t]))) {
+                  continue;
+               }
+
+               m_optimal_sequences[t] = found;
+               m_makespans[t] = unit.makespans[t];
+               m_updated_makespan++;
+               learn_moves(found);
+
+               notify_improvement({
+                    .makespan = m_makespans[t],
+                    .lower_bound = std::max(m_lower_bound, m_lower_bounds[t]),
+                    .threads = t,
+                    .elapsed_time = elapsed_time()});
+            }
          }
       }
+
+      m_work_units.clear();
    }
 
-   inline auto cheapest_accumulation(const std::size_t j) -> Operation {
-      const Jacobian& jac = m_chain.get_jacobian(j, j);
-      Operation op {
-           .action = Action::ACCUMULATION,
-           .mode = Mode::TANGENT,
-           .j = j,
-           .k = j,
-           .i = j,
-           .fma = jac.fma<Mode::TANGENT>()};
+   //! Called for every work unit in the fixed enumeration order of a worker
+   //! process. Returns true if this process claimed the unit.
+   inline auto claim_work_unit() -> bool {
+      if (m_work_unit_counter++ != m_claimed_work_unit) {
+         return false;
+      }
+
+      m_claimed_work_unit = m_shared->next_work_unit.fetch_add(1);
+      pull_shared_incumbents();
+      return true;
+   }
 
-      if (m_available_memory == 0 || m_available_memory >= jac.edges_in_dag) {
-         const std::size_t adjoint_fma = jac.fma<Mode::ADJOINT>();
-         if (adjoint_fma < op.fma) {
-            op.mode = Mode::ADJOINT;
-            op.fma = adjoint_fma;
+   inline auto pull_shared_incumbents() -> void {
+#if defined(__linux__)
+      for (std::size_t t = m_first_threads; t <= m_last_threads; ++t) {
+         m_makespans[t] = std::min(
+              m_makespans[t],
+              shared_incumbent(t)->makespan.load(std::memory_order_relaxed));
+      }
+#endif
+   }
+
+   inline auto push_shared_incumbent(const std::size_t t) -> void {
+#if defined(__linux__)
+      SharedIncumbent* incumbent = shared_incumbent(t);
+      lock_shared_incumbents();
+
+      if (m_makespans[t] < incumbent->makespan.load()) {
+         // A worker that dies while copying leaves no operations behind
+         incumbent->length = 0;
+         std::ranges::copy(m_optimal_sequences[t], shared_operations(t));
+         incumbent->length = m_optimal_sequences[t].length();
+         incumbent->elapsed_time = elapsed_time();
+         incumbent->makespan.store(m_makespans[t]);
+      }
+
+      pthread_mutex_unlock(&shared_state()->lock);
+#else
+      static_cast<void>(t);
+#endif
+   }
+
+#if defined(__linux__)
+   //! Byte offset of the incumbent for t threads in the shared memory. The
+   //! shared memory holds the SharedState, the pruning counters per sequence
+   //! length and for every amount of threads a SharedIncumbent, followed by
+   //! the operations of its sequence.
+   inline auto shared_incumbent_offset(const std::size_t t) const
+        -> std::size_t {
+      using util::SharedMemory;
+      const std::size_t max_length = m_pruned_branches.size() - 1;
+      const std::size_t header =
+           SharedMemory::align(sizeof(SharedState)) +
+           SharedMemory::align(
+                m_pruned_branches.size() * sizeof(std::atomic<std::size_t>));
+      const std::size_t stride =
+           SharedMemory::align(sizeof(SharedIncumbent)) +
+           SharedMemory::align(max_length * sizeof(Operation));
+      return header + t * stride;
+   }
+
+   inline auto shared_state() const -> SharedState* {
+      return m_shared_memory->at<SharedState>(0);
+   }
+
+   //! Locks the incumbents in the shared memory. If the previous owner died,
+   //! the incumbent it was writing has no operations and is never merged.
+   inline auto lock_shared_incumbents() const -> void {
+      if (pthread_mutex_lock(&shared_state()->lock) == EOWNERDEAD) {
+         pthread_mutex_consistent(&shared_state()->lock);
+      }
+   }
+
+   //! Adopts the incumbents of the workers that are better than the own
+   //! ones and reports them as improvements.
+   inline auto merge_shared_incumbents() -> void {
+      lock_shared_incumbents();
+      for (std::size_t t = m_first_threads; t <= m_last_threads; ++t) {
+         const SharedIncumbent* incumbent = shared_incumbent(t);
+         if (incumbent->length == 0 ||
+             incumbent->makespan.load() >= m_makespans[t]) {
+            continue;
          }
+
+         const Operation* ops = shared_operations(t);
+         m_optimal_sequences[t].assign(ops, ops + incumbent->length);
+         m_makespans[t] = incumbent->makespan.load();
+
+         notify_improvement({
+              .makespan = m_makespans[t],
+              .lower_bound = std::max(m_lower_bound, m_lower_bounds[t]),
+              .threads = t,
+              .elapsed_time = incumbent->elapsed_time});
       }
+      pthread_mutex_unlock(&shared_state()->lock);
+   }
 
-      return op;
+   inline auto shared_pruned_branches() const -> std::atomic<std::size_t>* {
+      return m_shared_memory->at<std::atomic<std::size_t>>(
+           util::SharedMemory::align(sizeof(SharedState)));
    }
 
-   inline auto push_possible_eliminations(
-        const JacobianChain& chain, std::vector<OpPair>& eliminations,
-        const std::size_t op_j, const std::size_t op_i) -> void {
-      OpPair ops {};
+   inline auto shared_incumbent(const std::size_t t) const
+        -> SharedIncumbent* {
+      return m_shared_memory->at<SharedIncumbent>(shared_incumbent_offset(t));
+   }
 
-      // Tangent or multiplication
-      if (op_j < chain.length() - 1) {
-         const std::size_t k = op_j;
-         const std::size_t i = op_i;
-         const Jacobian& ki_jac = chain.get_jacobian(k, i);
+   inline auto shared_operations(const std::size_t t) const -> Operation* {
+      return m_shared_memory->at<Operation>(
+           shared_incumbent_offset(t) +
+           util::SharedMemory::align(sizeof(SharedIncumbent)));
+   }
 
-         // Add multiplication if possible
-         std::size_t j;
-         for (j = m_chain.length() - 1; j >= k + 1; --j) {
-            const Jacobian& jk_jac = chain.get_jacobian(j, k + 1);
-            if (!jk_jac.is_accumulated || jk_jac.is_used) {
-               continue;
-            }
+   //! Forks m_processes workers that claim work units from a shared counter
+   //! and share their incumbents. Every worker searches with a single thread
+   //! since the OpenMP runtime can't be used after fork(). The best sequences
+   //! are merged (and reported) while the workers run, the statistics once
+   //! all workers finished.
+   inline auto search_in_processes() -> void {
+      m_timer_expired = false;
 
-            ops[0] = Operation {
-                 .action = Action::MULTIPLICATION,
-                 .j = j,
-                 .k = k,
-                 .i = i,
-                 .fma = jk_jac.m * ki_jac.m * ki_jac.n};
+      util::SharedMemory memory(shared_incumbent_offset(m_last_threads + 1));
+      m_shared_memory = &memory;
+      SharedState* shared = new (memory.at<void>(0)) SharedState {};
+      pthread_mutexattr_t lock_attr;
+      pthread_mutexattr_init(&lock_attr);
+      pthread_mutexattr_setpshared(&lock_attr, PTHREAD_PROCESS_SHARED);
+      pthread_mutexattr_setrobust(&lock_attr, PTHREAD_MUTEX_ROBUST);
+      pthread_mutex_init(&shared->lock, &lock_attr);
+      pthread_mutexattr_destroy(&lock_attr);
+      for (std::size_t len = 0; len < m_pruned_branches.size(); ++len) {
+         new (shared_pruned_branches() + len) std::atomic<std::size_t> {0};
+      }
+      for (std::size_t t = 0; t <= m_last_threads; ++t) {
+         new (shared_incumbent(t)) SharedIncumbent {.makespan = m_makespans[t]};
+      }
 
+      std::vector<pid_t> workers {};
+      for (std::size_t p = 0; p < m_processes; ++p) {
+         const pid_t pid = fork();
+         if (pid < 0) {
             break;
          }
 
-         // Add tangent elimination if multiplication wasn't possible
-         if (k + 1 == ++j && m_matrix_free) {
-            const Jacobian& jk_jac = chain.get_jacobian(j, k + 1);
-            assert(!jk_jac.is_accumulated && !jk_jac.is_used);
+         if (pid == 0) {
+            int status = 0;
+            try {
+               run_worker(shared);
+            } catch (...) {
+               status = 1;
+            }
+            _exit(status);
+         }
+
+         workers.push_back(pid);
+      }
+
+      const bool forked = !workers.empty();
+      bool lost_worker = !forked;
+      while (!workers.empty()) {
+         std::erase_if(workers, [&lost_worker](const pid_t pid) {
+            int status = 0;
+            const pid_t result = waitpid(pid, &status, WNOHANG);
+            if (result == 0) {
+               return false;
+            }
+            lost_worker |= result < 0 || !WIFEXITED(status) ||
+                           WEXITSTATUS(status) != 0;
+            return true;
+         });
 
-            ops[0] = Operation {
-                 .action = Action::ELIMINATION,
-                 .mode = Mode::TANGENT,
-                 .j = j,
-                 .k = k,
-                 .i = i,
-                 .fma = jk_jac.fma<Mode::TANGENT>(ki_jac.n)};
+         merge_shared_incumbents();
+         if (!workers.empty()) {
+            std::this_thread::sleep_for(SHARED_POLL_INTERVAL);
          }
       }
+      pthread_mutex_destroy(&shared->lock);
 
-      // Adjoint or multiplication
-      if (op_i > 0) {
-         const std::size_t k = op_i - 1;
-         const std::size_t j = op_j;
-         const Jacobian& jk_jac = chain.get_jacobian(j, k + 1);
+      if (lost_worker) {
+         // Work units of a failed worker may not have been searched
+         m_shared_memory = nullptr;
+         m_timer_expired = true;
+         if (!forked) {
+            traverse();
+         }
+         return;
+      }
 
-         // Add multiplication if possible
-         std::size_t i;
-         for (i = 0; i <= k; ++i) {
-            const Jacobian& ki_jac = chain.get_jacobian(k, i);
-            if (!ki_jac.is_accumulated || ki_jac.is_used) {
-               continue;
-            }
+      // Merge the statistics of all workers
+      m_leafs += shared->leafs.load();
+      m_updated_makespan += shared->updated_makespan.load();
+      m_timer_expired |= shared->timer_expired.load();
+      for (std::size_t len = 0; len < m_pruned_branches.size(); ++len) {
+         m_pruned_branches[len] += shared_pruned_branches()[len].load();
+      }
 
-            ops[1] = Operation {
-                 .action = Action::MULTIPLICATION,
-                 .j = j,
-                 .k = k,
-                 .i = i,
-                 .fma = jk_jac.m * ki_jac.m * ki_jac.n};
-            break;
+      m_shared_memory = nullptr;
+   }
+
+   //! Body of a worker process.
+   inline auto run_worker(SharedState* shared) -> void {
+      m_shared = shared;
+      m_work_unit_counter = 0;
+      m_claimed_work_unit = m_shared->next_work_unit.fetch_add(1);
+
+      m_leafs = 0;
+      m_updated_makespan = 0;
+      std::ranges::fill(m_pruned_branches, 0);
+
+      traverse();
+
+      m_shared->leafs += m_leafs;
+      m_shared->updated_makespan += m_updated_makespan;
+      if (!finished_in_time()) {
+         m_shared->timer_expired = true;
+      }
+      for (std::size_t len = 0; len < m_pruned_branches.size(); ++len) {
+         shared_pruned_branches()[len] += m_pruned_branches[len];
+      }
+   }
+#endif
+
+   //! Schedules a final sequence for every thread count within a work unit.
+   //! Ties are broken by the canonical order of the scheduled sequences.
+   inline auto schedule_in_work_unit(Sequence& sequence, WorkUnit& unit)
+        -> void {
+      const std::size_t critical_path = sequence.critical_path();
+      const std::size_t sequential_makespan = sequence.sequential_makespan();
+
+      for (std::size_t t = m_first_threads; t <= m_last_threads; ++t) {
+         std::size_t& makespan = unit.makespans[t];
+         if (lower_bound(critical_path, sequential_makespan, t) > makespan) {
+            continue;
          }
 
-         // Add adjoint elimination if multiplication wasn't possible
-         if (k == --i && m_matrix_free) {
-            const Jacobian& ki_jac = chain.get_jacobian(k, i);
-            assert(!ki_jac.is_accumulated && !ki_jac.is_used);
-
-            if (m_available_memory == 0 ||
-                m_available_memory >= ki_jac.edges_in_dag) {
-               ops[1] = Operation {
-                    .action = Action::ELIMINATION,
-                    .mode = Mode::ADJOINT,
-                    .j = j,
-                    .k = k,
-                    .i = i,
-                    .fma = ki_jac.fma<Mode::ADJOINT>(jk_jac.m)};
-            }
+         // Upper bound + 1 to find schedules that tie with the incumbent
+         Sequence final_sequence = sequence;
+         const std::size_t new_makespan = m_scheduler->schedule(
+              final_sequence, t,
+              makespan + (makespan < std::numeric_limits<std::size_t>::max()),
+              unit.token);
+
+         #pragma omp atomic
+         m_leafs++;
+
+         if (new_makespan > makespan ||
+             new_makespan == std::numeric_limits<std::size_t>::max()) {
+            continue;
+         }
+
+         Sequence& found = unit.optimal_sequences[t];
+         if (new_makespan < makespan || found.empty() ||
+             canonical_less(final_sequence, found)) {
+            found = std::move(final_sequence);
+            makespan = new_makespan;
          }
       }
+   }
 
-      eliminations.push_back(ops);
+   //! Strict weak order on scheduled sequences, independent of how and by
+   //! which thread they were found.
+   inline static auto canonical_less(const Sequence& lhs, const Sequence& rhs)
+        -> bool {
+      return std::ranges::lexicographical_compare(
+           lhs, rhs, [](const Operation& a, const Operation& b) -> bool {
+              return std::tie(
+                          a.action, a.mode, a.j, a.k, a.i, a.thread,
+                          a.start_time) <
+                     std::tie(
+                          b.action, b.mode, b.j, b.k, b.i, b.thread,
+                          b.start_time);
+           });
+   }
+
+   //! Unique index of an accumulation, a multiplication or a
+   //! single-elemental elimination. Accumulations use the diagonal of the
+   //! multiplications, which is never used otherwise.
+   inline auto move_index(const Operation& op) const -> std::size_t {
+      if (op.action == Action::ACCUMULATION) {
+         return (op.j * m_length + op.j) * m_length + op.j;
+      }
+      const std::size_t slice = (op.action == Action::MULTIPLICATION)
+                                     ? 0
+                                     : static_cast<std::size_t>(op.mode);
+      return ((slice * m_length + op.j) * m_length + op.k) * m_length + op.i;
    }
 };
 
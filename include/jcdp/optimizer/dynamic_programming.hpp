@@ -44,58 +44,58 @@ class DynamicProgrammingOptimizer : public Optimizer {
 
    virtual auto init(const JacobianChain& chain) -> void override final {
       Optimizer::init(chain);
-
-      std::size_t dp_nodes = m_length * (m_length + 1) / 2;
-      if (m_usable_threads > 0) {
-         dp_nodes *= m_usable_threads;
-
-         // Correct for preaccumulation nodes which only ever use one thread
-         dp_nodes -= (m_usable_threads - 1) * m_length;
-      }
-
-      m_dptable.clear();
-      m_dptable.resize(dp_nodes);
+      m_dptable.assign(column_offset(m_length), DPNode {});
    }
 
    virtual auto solve() -> Sequence override final {
-      const std::ptrdiff_t j_max = static_cast<std::ptrdiff_t>(m_length);
+      solve_subchains(0, m_length - 1);
+      return get_sequence();
+   }
 
-      // Accumulation costs
-      #pragma omp parallel for
-      for (std::ptrdiff_t j = 0; j < j_max; ++j) {
-         try_accumulation<Mode::TANGENT>(j);
-         try_accumulation<Mode::ADJOINT>(j);
-      }
+   //! Re-solves the chain after the sizes or costs of the elemental Jacobians
+   //! first, ..., last changed. Only the DP nodes of sub-chains that contain
+   //! at least one of these elementals are recomputed. The sub-chains of the
+   //! chain have to be updated beforehand (JacobianChain::update_subchains).
+   //! If the output size m of elemental e changed, the input size n of
+   //! elemental e + 1 changes as well, i.e. both have to be in the range.
+   auto update(
+        const std::size_t first, const std::optional<std::size_t> last = {})
+        -> Sequence {
+      const std::size_t last_idx = std::min(last.value_or(first), m_length - 1);
+      assert(first <= last_idx);
 
-      // Iterate over amount of available threads. m_usable_threads can be 0
-      // which means unlimited threads, therefore using do-while loop here.
+      // Reset all affected nodes
       std::size_t threads = 1;
       do {
-         for (std::size_t len = 2; len <= m_length; ++len) {
-            // Chains with same lengths and threads are independent!
-            #pragma omp parallel for
-            for (std::ptrdiff_t j = len - 1; j < j_max; ++j) {
-               const std::ptrdiff_t i = j - (len - 1);
-
-               for (std::ptrdiff_t k = i; k < j; k++) {
-                  try_multiplication(j, i, k, threads);
-
-                  if (m_matrix_free) {
-                     try_elimination<Mode::TANGENT>(j, i, k, threads);
-
-                     // Search for adjoint elimination from the back to the
-                     // to get the longest adjoint elimination chain possible.
-                     // Otherwise we get a lot of single adjoint eliminations
-                     // one after another. Doesn't affect fma, just reduces work
-                     // and makes output smaller.
-                     const std::size_t k2 = j - (k - i + 1);
-                     try_elimination<Mode::ADJOINT>(j, i, k2, threads);
-                  }
+         for (std::size_t j = first; j < m_length; ++j) {
+            for (std::size_t i = 0; i <= std::min(j, last_idx); ++i) {
+               if (i != j || threads == 1) {
+                  node(j, i, threads) = DPNode {};
                }
             }
          }
       } while (++threads <= m_usable_threads);
 
+      solve_subchains(first, last_idx);
+      return get_sequence();
+   }
+
+   //! Extends the solution after an elemental Jacobian was appended to the
+   //! chain (JacobianChain::append). Only the DP nodes of the new sub-chains
+   //! (j = q - 1, all i and threads) are computed, all other nodes are
+   //! reused. If the amount of usable threads grows with the chain length,
+   //! the whole table has to be recomputed.
+   auto append() -> Sequence {
+      const std::size_t usable_threads = std::min(
+           m_available_threads, m_chain->length());
+      if (usable_threads != m_usable_threads) {
+         init(*m_chain);
+         return solve();
+      }
+
+      m_length = m_chain->length();
+      m_dptable.resize(column_offset(m_length));
+      solve_subchains(m_length - 1, m_length - 1);
       return get_sequence();
    }
 
@@ -184,20 +184,76 @@ class DynamicProgrammingOptimizer : public Optimizer {
  private:
    std::vector<DPNode> m_dptable;
 
+   //! Computes all DP nodes of sub-chains (j, i) with i <= last and
+   //! j >= first, i.e. sub-chains that contain at least one of the elemental
+   //! Jacobians first, ..., last. Nodes of shorter sub-chains are either
+   //! unaffected or computed before the longer ones.
+   auto solve_subchains(const std::size_t first, const std::size_t last)
+        -> void {
+      const std::ptrdiff_t j_first = static_cast<std::ptrdiff_t>(first);
+      const std::ptrdiff_t j_last = static_cast<std::ptrdiff_t>(last);
+      const std::ptrdiff_t j_max = static_cast<std::ptrdiff_t>(m_length);
+
+      // Accumulation costs
+      #pragma omp parallel for
+      for (std::ptrdiff_t j = j_first; j <= j_last; ++j) {
+         try_accumulation<Mode::TANGENT>(j);
+         try_accumulation<Mode::ADJOINT>(j);
+      }
+
+      // Iterate over amount of available threads. m_usable_threads can be 0
+      // which means unlimited threads, therefore using do-while loop here.
+      std::size_t threads = 1;
+      do {
+         for (std::ptrdiff_t len = 2; len <= j_max; ++len) {
+            const std::ptrdiff_t j_begin = std::max(len - 1, j_first);
+            const std::ptrdiff_t j_end = std::min(j_max, j_last + len);
+
+            // Chains with same lengths and threads are independent!
+            #pragma omp parallel for if (j_end - j_begin > 1)
+            for (std::ptrdiff_t j = j_begin; j < j_end; ++j) {
+               const std::ptrdiff_t i = j - (len - 1);
+
+               for (std::ptrdiff_t k = i; k < j; k++) {
+                  try_multiplication(j, i, k, threads);
+
+                  if (m_matrix_free) {
+                     try_elimination<Mode::TANGENT>(j, i, k, threads);
+
+                     // Search for adjoint elimination from the back to the
+                     // to get the longest adjoint elimination chain possible.
+                     // Otherwise we get a lot of single adjoint eliminations
+                     // one after another. Doesn't affect fma, just reduces work
+                     // and makes output smaller.
+                     const std::size_t k2 = j - (k - i + 1);
+                     try_elimination<Mode::ADJOINT>(j, i, k2, threads);
+                  }
+               }
+            }
+         }
+      } while (++threads <= m_usable_threads);
+   }
+
+   //! Index of the first DP node of column j. The table is stored column by
+   //! column (all nodes with the same j are contiguous), which allows to
+   //! append new columns without moving the existing nodes. Every column
+   //! holds one node per thread count for the sub-chains (j, i < j) and a
+   //! single accumulation node (j, j), which only ever uses one thread.
+   auto column_offset(const std::size_t j) const -> std::size_t {
+      const std::size_t threads = std::max<std::size_t>(m_usable_threads, 1);
+      return j + threads * j * (j - 1) / 2;
+   }
+
    auto node(const std::size_t j, const std::size_t i, const std::size_t t)
         -> DPNode& {
       assert(j < m_length);
       assert(i < m_length && i <= j);
 
-      std::size_t idx = j * (j + 1) / 2 + i;
+      const std::size_t threads = std::max<std::size_t>(m_usable_threads, 1);
+      std::size_t idx = column_offset(j) + i * threads;
       if (m_usable_threads > 0 && j != i) {
          assert(t <= m_usable_threads);
-         idx += (t - 1) * (m_length + 1) * (m_length) / 2;
-
-         // Correct for preaccumulation nodes which only ever use one thread
-         if (t >= 2) {
-            idx -= (t - 2) * m_length + j;
-         }
+         idx += t - 1;
       }
       return m_dptable[idx];
    }
@@ -207,14 +263,14 @@ class DynamicProgrammingOptimizer : public Optimizer {
       std::size_t fma;
       if constexpr (mode == Mode::ADJOINT) {
          if (m_available_memory > 0) {
-            const std::size_t mem = m_chain.get_jacobian(j, j).edges_in_dag;
+            const std::size_t mem = m_chain->get_jacobian(j, j).edges_in_dag;
             if (mem > m_available_memory) {
                return;
             }
          }
       }
 
-      fma = m_chain.get_jacobian(j, j).fma<mode>();
+      fma = m_chain->get_jacobian(j, j).fma<mode>();
       DPNode& fma_ji = node(j, j, 1);
       if (fma < fma_ji.cost) {
          fma_ji.op.action = Action::ACCUMULATION;
@@ -267,9 +323,9 @@ class DynamicProgrammingOptimizer : public Optimizer {
       }
 
       // Dense
-      const std::size_t fma = m_chain.elemental_jacobians[j].m *
-                              m_chain.elemental_jacobians[k].m *
-                              m_chain.elemental_jacobians[i].n;
+      const std::size_t fma = m_chain->elemental_jacobians[j].m *
+                              m_chain->elemental_jacobians[k].m *
+                              m_chain->elemental_jacobians[i].n;
       cost += fma;
 
       DPNode& fma_ji = node(j, i, t);
@@ -294,7 +350,7 @@ class DynamicProgrammingOptimizer : public Optimizer {
       std::size_t fma;
       if constexpr (mode == Mode::ADJOINT) {
          if (m_available_memory > 0) {
-            const std::size_t mem = m_chain.get_jacobian(k, i).edges_in_dag;
+            const std::size_t mem = m_chain->get_jacobian(k, i).edges_in_dag;
             if (mem > m_available_memory) {
                return;
             }
@@ -303,15 +359,15 @@ class DynamicProgrammingOptimizer : public Optimizer {
          const DPNode& fma_jk = node(j, k + 1, t);
          assert(fma_jk.visited);
 
-         fma = m_chain.get_jacobian(k, i).fma<mode>(
-              m_chain.elemental_jacobians[j].m);
+         fma = m_chain->get_jacobian(k, i).fma<mode>(
+              m_chain->elemental_jacobians[j].m);
          cost = fma_jk.cost + fma;
       } else {
          const DPNode& fma_ki = node(k, i, t);
          assert(fma_ki.visited);
 
-         fma = m_chain.get_jacobian(j, k + 1).fma<mode>(
-              m_chain.elemental_jacobians[i].n);
+         fma = m_chain->get_jacobian(j, k + 1).fma<mode>(
+              m_chain->elemental_jacobians[i].n);
          cost = fma_ki.cost + fma;
       }
 
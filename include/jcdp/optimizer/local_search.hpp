@@ -0,0 +1,774 @@
+/******************************************************************************
+ * @file jcdp/optimizer/local_search.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides an optimizer that
+ *        improves a bracketing (elimination sequence) of a Jacobian chain via
+ *        simulated annealing with a tabu list. Suited for chains that are too
+ *        long for the branch & bound optimizer.
+ ******************************************************************************/
+
+#ifndef JCDP_OPTIMIZER_LOCAL_SEARCH_HPP_
+#define JCDP_OPTIMIZER_LOCAL_SEARCH_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <print>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "jcdp/jacobian.hpp"
+#include "jcdp/jacobian_chain.hpp"
+#include "jcdp/operation.hpp"
+#include "jcdp/optimizer/optimizer.hpp"
+#include "jcdp/sequence.hpp"
+#include "jcdp/util/improvement.hpp"
+#include "jcdp/util/timer.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::optimizer {
+
+/******************************************************************************
+ * @brief Local search over bracketings and accumulation modes.
+ *
+ * A solution stores one operation per sub-chain (j, i) that describes how the
+ * sub-chain is computed: accumulation (j = i), multiplication or elimination
+ * at split k. Every stored operation is valid on its own, the sequence is
+ * formed by the operations reachable from the whole chain. Hence, a move only
+ * changes one or two sub-chains and never has to repair the rest.
+ *
+ * Every walker starts from the incumbent (e.g. the DP sequence), applies
+ * random moves (rotate a bracket or shift its split, flip tangent / adjoint,
+ * swap multiplication and elimination) and accepts them with the simulated
+ * annealing criterion. Recently changed sub-chains are tabu. A move is first
+ * checked against a lower bound from cached sub-chain aggregates and only
+ * list scheduled if it may be accepted. The list schedule of the current
+ * sequence is kept, so only the operations from the first one that the move
+ * changed in the scheduling order onwards are re-timed. Restarts continue
+ * from the best sequence of the walker after a random perturbation.
+ ******************************************************************************/
+class LocalSearchOptimizer : public Optimizer,
+                             public util::Timer,
+                             public util::ImprovementNotifier {
+ public:
+   LocalSearchOptimizer() : Optimizer() {
+      register_property(
+           m_time_to_solve, "time_to_solve",
+           "Maximal runtime for the local search in seconds.");
+      register_property(
+           m_walkers, "walkers",
+           "Amount of independent walkers of the local search (run in "
+           "parallel).");
+      register_property(
+           m_restarts, "restarts",
+           "Amount of restarts of every walker of the local search.");
+      register_property(
+           m_moves, "moves",
+           "Amount of moves per restart of a walker of the local search.");
+      register_property(
+           m_temperature, "temperature",
+           "Initial temperature of the local search relative to the makespan "
+           "of the start sequence.");
+      register_property(
+           m_tabu_tenure, "tabu_tenure",
+           "Amount of moves after which a changed sub-chain may be changed "
+           "again by the local search.");
+      register_property(
+           m_seed, "seed", "Seed for the random number generator.");
+   }
+
+   virtual ~LocalSearchOptimizer() = default;
+
+   virtual auto init(const JacobianChain& chain) -> void override final {
+      Optimizer::init(chain);
+      m_start.reset();
+      m_best.assign_max();
+      m_lower_bound = 0;
+      m_timer_expired = false;
+
+      m_moves_evaluated = 0;
+      m_moves_scheduled = 0;
+      m_moves_accepted = 0;
+   }
+
+   virtual auto solve() -> Sequence override final {
+      start_timer();
+      m_best.assign_max();
+      m_best_makespan = std::numeric_limits<std::size_t>::max();
+
+      const std::size_t walkers = std::max<std::size_t>(m_walkers, 1);
+      std::vector<Walker> results(walkers);
+
+      #pragma omp parallel for schedule(dynamic, 1)
+      for (std::size_t w = 0; w < walkers; ++w) {
+         walk(results[w], m_seed + w);
+      }
+
+      // Merge in a fixed order, so the result doesn't depend on the timing
+      // of the walkers (unless the time limit is hit).
+      std::size_t best_makespan = std::numeric_limits<std::size_t>::max();
+      for (Walker& walker : results) {
+         m_moves_evaluated += walker.moves_evaluated;
+         m_moves_scheduled += walker.moves_scheduled;
+         m_moves_accepted += walker.moves_accepted;
+         if (walker.best_makespan < best_makespan) {
+            best_makespan = walker.best_makespan;
+            m_best = walker.best_sequence;
+         }
+      }
+
+      m_timer_expired |= m_token.is_cancelled();
+      return m_best;
+   }
+
+   //! Sets the sequence the walkers start from, e.g. the DP sequence. It
+   //! doesn't have to be scheduled. Without a start sequence, the chain is
+   //! accumulated tangent-wise and multiplied from right to left.
+   inline auto set_incumbent(const Sequence& sequence) -> void {
+      m_start = sequence;
+   }
+
+   //! Sets a proven lower bound for the makespan. It is only reported along
+   //! with improvements of the incumbent.
+   inline auto set_lower_bound(const std::size_t lower_bound) -> void {
+      m_lower_bound = lower_bound;
+   }
+
+   inline auto print_stats() -> void {
+      std::println("Moves evaluated: {}", m_moves_evaluated);
+      std::println("Moves scheduled: {}", m_moves_scheduled);
+      std::println("Moves accepted: {}", m_moves_accepted);
+   }
+
+ private:
+   std::size_t m_walkers {4};
+   std::size_t m_restarts {4};
+   std::size_t m_moves {10000};
+   double m_temperature {0.05};
+   std::size_t m_tabu_tenure {4};
+   std::size_t m_seed {0};
+
+   std::optional<Sequence> m_start {};
+   Sequence m_best {Sequence::make_max()};
+   std::size_t m_best_makespan {std::numeric_limits<std::size_t>::max()};
+   std::size_t m_lower_bound {0};
+
+   std::size_t m_moves_evaluated {0};
+   std::size_t m_moves_scheduled {0};
+   std::size_t m_moves_accepted {0};
+
+   static constexpr std::size_t NO_OPERAND =
+        std::numeric_limits<std::size_t>::max();
+
+   //! Total fma and critical path of the operations that compute a
+   //! sub-chain, i.e. of the subtree rooted at the sub-chain.
+   struct Aggregate {
+      std::size_t fma {0};
+      std::size_t critical_path {0};
+      bool is_valid {false};
+   };
+
+   //! Previous operations of the sub-chains changed by a move.
+   struct Move {
+      std::array<Operation, 2> previous {};
+      std::size_t changes {0};
+   };
+
+   //! Sequence with its list schedule. The operands and the level of every
+   //! operation are stored at the same index, the thread loads before every
+   //! step of the scheduling order in consecutive rows.
+   struct Schedule {
+      Sequence sequence {};
+      std::vector<std::array<std::size_t, 2>> operands {};
+      std::vector<std::size_t> levels {};
+      std::vector<std::size_t> order {};
+      std::vector<std::size_t> thread_loads {};
+      std::size_t threads {0};
+      //! First step that was not taken over from the reference schedule.
+      std::size_t first_step {0};
+   };
+
+   struct Walker {
+      std::vector<Operation> nodes {};
+      std::vector<Aggregate> aggregates {};
+      std::vector<std::size_t> tabu_until {};
+
+      // Current schedule and a buffer for the evaluation of a move
+      Schedule current {};
+      Schedule candidate {};
+      std::size_t makespan {0};
+
+      std::vector<Operation> best_nodes {};
+      Sequence best_sequence {Sequence::make_max()};
+      std::size_t best_makespan {std::numeric_limits<std::size_t>::max()};
+
+      std::mt19937_64 gen {};
+      std::size_t moves_evaluated {0};
+      std::size_t moves_scheduled {0};
+      std::size_t moves_accepted {0};
+   };
+
+   //! Index of sub-chain (j, i) in the per-walker arrays.
+   inline static auto node_index(const std::size_t j, const std::size_t i)
+        -> std::size_t {
+      return j * (j + 1) / 2 + i;
+   }
+
+   inline auto walk(Walker& w, const std::size_t seed) -> void {
+      w.gen.seed(seed);
+      init_nodes(w);
+      w.makespan = evaluate(w, w.current);
+      save_best(w);
+
+      // Moves are drawn from the operations of the current sequence
+      std::uniform_real_distribution<double> uniform(0.0, 1.0);
+      const double cooling = std::pow(
+           1e-3, 1.0 / static_cast<double>(std::max<std::size_t>(m_moves, 1)));
+
+      std::size_t iteration = 0;
+      for (std::size_t restart = 0; restart <= m_restarts; ++restart) {
+         if (restart > 0) {
+            // Perturb the best sequence of this walker
+            w.nodes = w.best_nodes;
+            invalidate_all(w);
+            w.makespan = evaluate(w, w.current);
+            for (std::size_t kick = 0; kick < m_length; ++kick) {
+               Move move;
+               random_move(w, move);
+               accept(w, evaluate(w, w.candidate, &w.current));
+            }
+         }
+
+         double temperature = m_temperature *
+                              static_cast<double>(w.makespan);
+         for (std::size_t m = 0; m < m_moves; ++m, ++iteration) {
+            if (!poll()) {
+               return;
+            }
+            temperature *= cooling;
+
+            Move move;
+            if (!random_move(w, move, iteration)) {
+               continue;
+            }
+            w.moves_evaluated++;
+
+            // Accept if the makespan is below the threshold. The threshold
+            // is drawn in advance to reject moves via the lower bound.
+            const double threshold = static_cast<double>(w.makespan) -
+                                     temperature *
+                                          std::log(1.0 - uniform(w.gen));
+            if (static_cast<double>(lower_bound(w)) > threshold) {
+               revert(w, move);
+               continue;
+            }
+
+            w.moves_scheduled++;
+            const std::size_t makespan = evaluate(
+                 w, w.candidate, &w.current);
+            if (static_cast<double>(makespan) > threshold) {
+               revert(w, move);
+               continue;
+            }
+
+            w.moves_accepted++;
+            accept(w, makespan);
+            for (std::size_t c = 0; c < move.changes; ++c) {
+               const Operation& op = move.previous[c];
+               w.tabu_until[node_index(op.j, op.i)] = iteration +
+                                                      m_tabu_tenure + 1;
+            }
+
+            if (makespan < w.best_makespan) {
+               save_best(w);
+            }
+         }
+      }
+   }
+
+   inline auto save_best(Walker& w) -> void {
+      w.best_nodes = w.nodes;
+      w.best_sequence = w.current.sequence;
+      w.best_makespan = w.makespan;
+
+      #pragma omp critical
+      {
+         if (w.makespan < m_best_makespan) {
+            m_best_makespan = w.makespan;
+            notify_improvement({
+                 .makespan = w.makespan,
+                 .lower_bound = m_lower_bound,
+                 .threads = m_usable_threads,
+                 .elapsed_time = elapsed_time()});
+         }
+      }
+   }
+
+   // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> SOLUTIONS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+   inline auto make_operation(
+        const Action action, const Mode mode, const std::size_t j,
+        const std::size_t k, const std::size_t i) const -> Operation {
+      Operation op {.action = action, .mode = mode, .j = j, .k = k, .i = i};
+      switch (action) {
+         case Action::ACCUMULATION: {
+            const Jacobian& jac = m_chain->get_jacobian(j, j);
+            op.fma = (mode == Mode::TANGENT) ? jac.fma<Mode::TANGENT>()
+                                             : jac.fma<Mode::ADJOINT>();
+         } break;
+
+         case Action::MULTIPLICATION: {
+            op.fma = m_chain->elemental_jacobians[j].m *
+                     m_chain->elemental_jacobians[k].m *
+                     m_chain->elemental_jacobians[i].n;
+         } break;
+
+         case Action::ELIMINATION: {
+            if (mode == Mode::TANGENT) {
+               op.fma = m_chain->get_jacobian(j, k + 1).fma<Mode::TANGENT>(
+                    m_chain->elemental_jacobians[i].n);
+            } else {
+               op.fma = m_chain->get_jacobian(k, i).fma<Mode::ADJOINT>(
+                    m_chain->elemental_jacobians[j].m);
+            }
+         } break;
+
+         default: {
+            assert(false);
+         }
+      }
+      return op;
+   }
+
+   //! Adjoint accumulations and eliminations need to store the tape of the
+   //! (sub-)chain that is evaluated in adjoint mode.
+   inline auto is_feasible(const Operation& op) const -> bool {
+      if (op.mode != Mode::ADJOINT || m_available_memory == 0) {
+         return true;
+      }
+      const std::size_t k = (op.action == Action::ACCUMULATION) ? op.j : op.k;
+      return m_chain->get_jacobian(k, op.i).edges_in_dag <= m_available_memory;
+   }
+
+   inline auto init_nodes(Walker& w) -> void {
+      w.nodes.resize(node_index(m_length, 0));
+      w.aggregates.resize(w.nodes.size());
+      w.tabu_until.assign(w.nodes.size(), 0);
+
+      for (std::size_t j = 0; j < m_length; ++j) {
+         Operation acc = make_operation(
+              Action::ACCUMULATION, Mode::ADJOINT, j, j, j);
+         const Operation tan = make_operation(
+              Action::ACCUMULATION, Mode::TANGENT, j, j, j);
+         if (!is_feasible(acc) || tan.fma <= acc.fma) {
+            acc = tan;
+         }
+         w.nodes[node_index(j, j)] = acc;
+
+         for (std::size_t i = 0; i < j; ++i) {
+            w.nodes[node_index(j, i)] = make_operation(
+                 Action::MULTIPLICATION, Mode::NONE, j, j - 1, i);
+         }
+      }
+
+      if (m_start.has_value()) {
+         for (const Operation& op : m_start.value()) {
+            if (op.action != Action::NONE) {
+               w.nodes[node_index(op.j, op.i)] = make_operation(
+                    op.action, op.mode, op.j, op.k, op.i);
+            }
+         }
+      }
+      invalidate_all(w);
+   }
+
+   inline auto change(Walker& w, Move& move, const Operation& op) -> void {
+      Operation& node = w.nodes[node_index(op.j, op.i)];
+      move.previous[move.changes++] = node;
+      node = op;
+      invalidate(w, op.j, op.i);
+   }
+
+   inline auto revert(Walker& w, Move& move) -> void {
+      while (move.changes > 0) {
+         const Operation& op = move.previous[--move.changes];
+         w.nodes[node_index(op.j, op.i)] = op;
+         invalidate(w, op.j, op.i);
+      }
+   }
+
+   // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> MOVES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+   //! Applies a random move to a random, non-tabu operation of the current
+   //! sequence. Returns false if no move was applied.
+   inline auto random_move(
+        Walker& w, Move& move,
+        const std::size_t iteration = std::numeric_limits<std::size_t>::max())
+        -> bool {
+      std::uniform_int_distribution<std::size_t> pick_op(
+           0, w.current.sequence.length() - 1);
+      const Operation op = w.current.sequence[pick_op(w.gen)];
+      if (iteration < w.tabu_until[node_index(op.j, op.i)]) {
+         return false;
+      }
+
+      if (op.action == Action::ACCUMULATION) {
+         return flip(w, move, op);
+      }
+
+      std::uniform_int_distribution<std::size_t> pick_move(0, 2);
+      switch (pick_move(w.gen)) {
+         case 0: {
+            if (rotate(w, move, op)) {
+               return true;
+            }
+         } break;
+
+         case 1: {
+            if (flip(w, move, op)) {
+               return true;
+            }
+         } break;
+
+         default: {
+            if (swap(w, move, op)) {
+               return true;
+            }
+         }
+      }
+      return shift(w, move, op);
+   }
+
+   //! Rotates the bracket of a multiplication with one of its operands,
+   //! i.e. A (B C) <-> (A B) C.
+   inline auto rotate(Walker& w, Move& move, const Operation& op) -> bool {
+      if (op.action != Action::MULTIPLICATION) {
+         return false;
+      }
+
+      const Operation& lhs = w.nodes[node_index(op.j, op.k + 1)];
+      const Operation& rhs = w.nodes[node_index(op.k, op.i)];
+      std::uniform_int_distribution<std::size_t> coin(0, 1);
+      const bool use_lhs = (lhs.action == Action::MULTIPLICATION) &&
+                           (rhs.action != Action::MULTIPLICATION ||
+                            coin(w.gen) == 0);
+
+      if (use_lhs) {
+         // ((J_j ... J_k2+1) (J_k2 ... J_k+1)) (J_k ... J_i)
+         const std::size_t k2 = lhs.k;
+         change(
+              w, move,
+              make_operation(
+                   Action::MULTIPLICATION, Mode::NONE, op.j, k2, op.i));
+         change(
+              w, move,
+              make_operation(
+                   Action::MULTIPLICATION, Mode::NONE, k2, op.k, op.i));
+         return true;
+      }
+
+      if (rhs.action == Action::MULTIPLICATION) {
+         // (J_j ... J_k+1) ((J_k ... J_k2+1) (J_k2 ... J_i))
+         const std::size_t k2 = rhs.k;
+         change(
+              w, move,
+              make_operation(
+                   Action::MULTIPLICATION, Mode::NONE, op.j, k2, op.i));
+         change(
+              w, move,
+              make_operation(
+                   Action::MULTIPLICATION, Mode::NONE, op.j, op.k, k2 + 1));
+         return true;
+      }
+
+      return false;
+   }
+
+   //! Flips the mode of an accumulation or elimination.
+   inline auto flip(Walker& w, Move& move, const Operation& op) -> bool {
+      if (op.mode == Mode::NONE) {
+         return false;
+      }
+
+      const Mode mode = (op.mode == Mode::TANGENT) ? Mode::ADJOINT
+                                                    : Mode::TANGENT;
+      const Operation flipped = make_operation(
+           op.action, mode, op.j, op.k, op.i);
+      if (!is_feasible(flipped)) {
+         return false;
+      }
+      change(w, move, flipped);
+      return true;
+   }
+
+   //! Swaps a multiplication for an elimination at the same split and vice
+   //! versa. Only possible for the matrix-free problem.
+   inline auto swap(Walker& w, Move& move, const Operation& op) -> bool {
+      if (!m_matrix_free) {
+         return false;
+      }
+
+      if (op.action == Action::ELIMINATION) {
+         change(
+              w, move,
+              make_operation(
+                   Action::MULTIPLICATION, Mode::NONE, op.j, op.k, op.i));
+         return true;
+      }
+
+      std::uniform_int_distribution<std::size_t> coin(0, 1);
+      Operation elimination = make_operation(
+           Action::ELIMINATION, (coin(w.gen) == 0) ? Mode::TANGENT
+                                                   : Mode::ADJOINT,
+           op.j, op.k, op.i);
+      if (!is_feasible(elimination)) {
+         elimination = make_operation(
+              Action::ELIMINATION, Mode::TANGENT, op.j, op.k, op.i);
+      }
+      change(w, move, elimination);
+      return true;
+   }
+
+   //! Moves the split of a multiplication or elimination.
+   inline auto shift(Walker& w, Move& move, const Operation& op) -> bool {
+      if (op.j - op.i < 2) {
+         return false;
+      }
+
+      std::uniform_int_distribution<std::size_t> pick_k(op.i, op.j - 2);
+      std::size_t k = pick_k(w.gen);
+      if (k >= op.k) {
+         ++k;
+      }
+
+      const Operation shifted = make_operation(
+           op.action, op.mode, op.j, k, op.i);
+      if (!is_feasible(shifted)) {
+         return false;
+      }
+      change(w, move, shifted);
+      return true;
+   }
+
+   // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> EVALUATION <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+   //! Invalidates the aggregates of all sub-chains that contain (j, i).
+   inline auto invalidate(Walker& w, const std::size_t j, const std::size_t i)
+        -> void {
+      for (std::size_t jj = j; jj < m_length; ++jj) {
+         for (std::size_t ii = 0; ii <= i; ++ii) {
+            w.aggregates[node_index(jj, ii)].is_valid = false;
+         }
+      }
+   }
+
+   inline auto invalidate_all(Walker& w) -> void {
+      for (Aggregate& aggregate : w.aggregates) {
+         aggregate.is_valid = false;
+      }
+   }
+
+   inline auto aggregate(Walker& w, const std::size_t j, const std::size_t i)
+        -> const Aggregate& {
+      Aggregate& agg = w.aggregates[node_index(j, i)];
+      if (agg.is_valid) {
+         return agg;
+      }
+
+      const Operation& op = w.nodes[node_index(j, i)];
+      agg = {.fma = op.fma, .critical_path = 0, .is_valid = true};
+      if (op.action != Action::ACCUMULATION) {
+         const bool has_lhs = !(op.action == Action::ELIMINATION &&
+                                op.mode == Mode::TANGENT);
+         const bool has_rhs = !(op.action == Action::ELIMINATION &&
+                                op.mode == Mode::ADJOINT);
+         if (has_lhs) {
+            const Aggregate& lhs = aggregate(w, j, op.k + 1);
+            agg.fma += lhs.fma;
+            agg.critical_path = lhs.critical_path;
+         }
+         if (has_rhs) {
+            const Aggregate& rhs = aggregate(w, op.k, i);
+            agg.fma += rhs.fma;
+            agg.critical_path = std::max(agg.critical_path, rhs.critical_path);
+         }
+      }
+      agg.critical_path += op.fma;
+      return agg;
+   }
+
+   inline auto lower_bound(Walker& w) -> std::size_t {
+      const Aggregate& agg = aggregate(w, m_length - 1, 0);
+      if (m_usable_threads == 0) {
+         return agg.critical_path;
+      }
+      return std::max(
+           agg.critical_path,
+           (agg.fma + m_usable_threads - 1) / m_usable_threads);
+   }
+
+   //! Appends the operations of sub-chain (j, i) in post-order and returns
+   //! the index of its last operation.
+   inline auto build(
+        Walker& w, Schedule& s, const std::size_t j, const std::size_t i,
+        const std::size_t level) -> std::size_t {
+      const Operation& op = w.nodes[node_index(j, i)];
+      std::array<std::size_t, 2> operands {NO_OPERAND, NO_OPERAND};
+
+      if (op.action != Action::ACCUMULATION) {
+         if (!(op.action == Action::ELIMINATION && op.mode == Mode::TANGENT)) {
+            operands[0] = build(w, s, j, op.k + 1, level + 1);
+         }
+         if (!(op.action == Action::ELIMINATION && op.mode == Mode::ADJOINT)) {
+            operands[1] = build(w, s, op.k, i, level + 1);
+         }
+      }
+
+      s.sequence.push_back(op);
+      s.operands.push_back(operands);
+      s.levels.push_back(level);
+      return s.sequence.length() - 1;
+   }
+
+   inline static auto is_same_operation(
+        const Operation& lhs, const Operation& rhs) -> bool {
+      return lhs.action == rhs.action && lhs.mode == rhs.mode &&
+             lhs.j == rhs.j && lhs.k == rhs.k && lhs.i == rhs.i;
+   }
+
+   //! Builds the sequence of the current solution and list schedules it like
+   //! the PriorityListScheduler, but uses the known tree structure instead of
+   //! searching the dependencies. Given a reference schedule, the steps in
+   //! front of the first operation that differs in the scheduling order keep
+   //! their times, as their operands are the same as well. Only the rest is
+   //! re-timed, starting from the saved thread loads of the reference.
+   inline auto evaluate(
+        Walker& w, Schedule& s, const Schedule* reference = nullptr)
+        -> std::size_t {
+      Sequence& sequence = s.sequence;
+      sequence.clear();
+      s.operands.clear();
+      s.levels.clear();
+      build(w, s, m_length - 1, 0, 1);
+
+      std::vector<std::size_t>& order = s.order;
+      order.resize(sequence.length());
+      std::iota(order.begin(), order.end(), 0);
+      std::sort(
+           order.begin(), order.end(),
+           [&](const std::size_t lhs, const std::size_t rhs) -> bool {
+              if (s.levels[lhs] != s.levels[rhs]) {
+                 return s.levels[lhs] > s.levels[rhs];
+              }
+              if (sequence[lhs].fma != sequence[rhs].fma) {
+                 return sequence[lhs].fma > sequence[rhs].fma;
+              }
+              return lhs < rhs;
+           });
+
+      // We can never use more threads than we have accumulations
+      std::size_t threads = sequence.count_accumulations();
+      if (m_usable_threads > 0 && m_usable_threads < threads) {
+         threads = m_usable_threads;
+      }
+      s.threads = threads;
+
+      std::size_t step = 0;
+      if (reference != nullptr && reference->threads == threads) {
+         const std::size_t steps = std::min(
+              order.size(), reference->order.size());
+         for (; step < steps; ++step) {
+            const Operation& ref_op =
+                 reference->sequence[reference->order[step]];
+            Operation& op = sequence[order[step]];
+            if (!is_same_operation(op, ref_op)) {
+               break;
+            }
+            op.thread = ref_op.thread;
+            op.start_time = ref_op.start_time;
+            op.is_scheduled = true;
+         }
+      }
+      s.first_step = step;
+
+      std::vector<std::size_t>& thread_loads = s.thread_loads;
+      thread_loads.resize((order.size() + 1) * threads);
+      if (step == 0) {
+         std::fill_n(thread_loads.begin(), threads, 0);
+      } else {
+         std::copy_n(
+              reference->thread_loads.begin() + step * threads, threads,
+              thread_loads.begin() + step * threads);
+      }
+
+      for (; step < order.size(); ++step) {
+         const std::size_t* loads = &thread_loads[step * threads];
+         Operation& op = sequence[order[step]];
+
+         std::size_t earliest_start = 0;
+         for (const std::size_t operand : s.operands[order[step]]) {
+            if (operand != NO_OPERAND) {
+               earliest_start = std::max(
+                    earliest_start,
+                    sequence[operand].start_time + sequence[operand].fma);
+            }
+         }
+
+         op.thread = 0;
+         op.start_time = std::max(loads[0], earliest_start);
+         std::size_t idle_time = op.start_time - loads[0];
+
+         for (std::size_t t = 1; t < threads; ++t) {
+            const std::size_t start_on_t = std::max(loads[t], earliest_start);
+            const std::size_t idle_on_t = start_on_t - loads[t];
+            if (start_on_t < op.start_time ||
+                (start_on_t == op.start_time && idle_on_t < idle_time)) {
+               op.thread = t;
+               op.start_time = start_on_t;
+               idle_time = idle_on_t;
+            }
+         }
+
+         std::size_t* next_loads = &thread_loads[(step + 1) * threads];
+         std::copy_n(loads, threads, next_loads);
+         next_loads[op.thread] = op.start_time + op.fma;
+         op.is_scheduled = true;
+      }
+
+      // Thread loads only grow, so the last ones contain the makespan
+      const std::size_t* loads = &thread_loads[order.size() * threads];
+      return *std::max_element(loads, loads + threads);
+   }
+
+   //! Makes the candidate the current schedule. The thread loads in front of
+   //! its first re-timed step are only stored in the current schedule.
+   inline static auto accept(Walker& w, const std::size_t makespan) -> void {
+      Schedule& current = w.current;
+      Schedule& candidate = w.candidate;
+      const std::size_t offset = candidate.first_step * candidate.threads;
+      current.thread_loads.resize(candidate.thread_loads.size());
+      std::copy(
+           candidate.thread_loads.begin() + offset,
+           candidate.thread_loads.end(), current.thread_loads.begin() + offset);
+
+      std::swap(current.sequence, candidate.sequence);
+      std::swap(current.operands, candidate.operands);
+      std::swap(current.levels, candidate.levels);
+      std::swap(current.order, candidate.order);
+      current.threads = candidate.threads;
+      w.makespan = makespan;
+   }
+};
+
+}  // end namespace jcdp::optimizer
+
+#endif  // JCDP_OPTIMIZER_LOCAL_SEARCH_HPP_
@@ -12,11 +12,22 @@
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
 #include <cstddef>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "jcdp/calibration.hpp"
+#include "jcdp/jacobian.hpp"
 #include "jcdp/jacobian_chain.hpp"
+#include "jcdp/operation.hpp"
+#include "jcdp/scheduler/scheduler.hpp"
 #include "jcdp/util/properties.hpp"
 
 namespace jcdp {
@@ -42,6 +53,29 @@ class Optimizer : public util::Properties {
       register_property(
            m_available_memory, "available_memory",
            "Amount of available persistent memory.");
+      register_property(
+           m_node_memory, "node_memory",
+           "Amount of memory shared by all threads (0 = unlimited).");
+      register_property(
+           m_memory_aware_scheduling, "memory_aware_scheduling",
+           "Whether the schedulers respect the available (node) memory.");
+      register_property(
+           m_transfer_cost, "transfer_cost",
+           "Latency and cost per entry of moving a Jacobian to another "
+           "thread.");
+      register_property(
+           m_numa_transfer_cost, "numa_transfer_cost",
+           "Latency and cost per entry of moving a Jacobian to another NUMA "
+           "domain.");
+      register_property(
+           m_numa_domains, "numa_domains",
+           "Amount of threads per NUMA domain.");
+      register_property(
+           m_calibration_file, "calibration_file",
+           "Calibration file with the seconds per fma of the host.",
+           [](util::Properties* optimizer) {
+              static_cast<Optimizer*>(optimizer)->load_calibration();
+           });
       register_property(
            m_available_threads, "available_threads",
            "Amount of threads that are available for the evaluation of the "
@@ -50,17 +84,51 @@ class Optimizer : public util::Properties {
 
    virtual ~Optimizer() = default;
 
+   //! Prepares the optimizer for the given chain. The chain is only
+   //! referenced, hence it has to outlive all subsequent calls to solve().
+   //! Internal buffers keep their capacity, so re-initializing with a chain
+   //! that is not longer than the previous one doesn't allocate.
    virtual auto init(const JacobianChain& chain) -> void {
       m_length = chain.length();
       m_usable_threads = std::min(m_available_threads, m_length);
-
-      m_chain = chain;
-      m_chain.optimized_costs.clear();
-      m_chain.optimized_costs.resize(1 + m_usable_threads);
+      m_chain = &chain;
    }
 
    virtual auto solve() -> Sequence = 0;
 
+   //! Links the optimizer to the makespan of an incumbent that is shared
+   //! with other solvers running at the same time (e.g. in a portfolio).
+   //! Partial sequences that can't beat it are dropped. The makespan refers
+   //! to m_usable_threads and has to outlive all subsequent solves.
+   inline auto set_shared_makespan(const std::atomic<std::size_t>* makespan)
+        -> void {
+      m_shared_makespan = makespan;
+   }
+
+   //! Hands the memory limits (if memory aware scheduling is enabled) and
+   //! the transfer costs of this optimizer to the given scheduler. Requires
+   //! a previous init().
+   inline auto configure_scheduler(scheduler::Scheduler& scheduler) const
+        -> void {
+      assert(m_chain != nullptr);
+      if (m_memory_aware_scheduling) {
+         scheduler.set_memory_limits(
+              *m_chain, m_available_memory, m_node_memory);
+      }
+      scheduler.set_transfer_costs(
+           *m_chain, m_transfer_cost, m_numa_transfer_cost, m_numa_domains);
+   }
+
+   //! Weights the costs of the chain with the calibration file (if given),
+   //! see Calibration::apply. Returns the seconds per (calibrated) fma.
+   inline auto calibrate(JacobianChain& chain) const -> std::optional<double> {
+      if (!m_calibration) {
+         return {};
+      }
+      m_calibration->apply(chain);
+      return m_calibration->seconds(1);
+   }
+
    std::size_t m_usable_threads {0};
 
  protected:
@@ -69,9 +137,142 @@ class Optimizer : public util::Properties {
    bool m_banded {false};
    bool m_sparse {false};
    std::size_t m_available_memory {0};
+   std::size_t m_node_memory {0};
+   bool m_memory_aware_scheduling {false};
+   std::pair<std::size_t, double> m_transfer_cost {0, 0.0};
+   std::pair<std::size_t, double> m_numa_transfer_cost {0, 0.0};
+   std::vector<std::size_t> m_numa_domains {};
+   std::string m_calibration_file {};
+   std::shared_ptr<const Calibration> m_calibration {};
    std::size_t m_available_threads {0};
 
-   JacobianChain m_chain;
+   const JacobianChain* m_chain {nullptr};
+   const std::atomic<std::size_t>* m_shared_makespan {nullptr};
+
+   //! Reads the calibration file whenever it is set (empty disables it).
+   inline auto load_calibration() -> void {
+      if (m_calibration_file.empty()) {
+         m_calibration.reset();
+         return;
+      }
+
+      std::shared_ptr<Calibration> calibration =
+           std::make_shared<Calibration>();
+      calibration->parse_config(m_calibration_file);
+      m_calibration = calibration;
+   }
+
+   //! Current makespan of the shared incumbent (maximum without one).
+   inline auto shared_makespan() const -> std::size_t {
+      if (m_shared_makespan == nullptr) {
+         return std::numeric_limits<std::size_t>::max();
+      }
+      return m_shared_makespan->load(std::memory_order_relaxed);
+   }
+
+   // Helpers for optimizers that build sequences one operation at a time
+
+   //! Operations that may follow an operation: at index 0 a multiplication
+   //! or tangent elimination with the sub-chain on the left, at index 1
+   //! with the sub-chain on the right (adjoint).
+   using OpPair = std::array<std::optional<Operation>, 2>;
+
+   //! Accumulation of elemental j in the cheaper mode that fits into memory.
+   inline auto cheapest_accumulation(const std::size_t j) -> Operation {
+      const Jacobian& jac = m_chain->get_jacobian(j, j);
+      Operation op {
+           .action = Action::ACCUMULATION,
+           .mode = Mode::TANGENT,
+           .j = j,
+           .k = j,
+           .i = j,
+           .fma = jac.fma<Mode::TANGENT>()};
+
+      if (m_available_memory == 0 || m_available_memory >= jac.edges_in_dag) {
+         const std::size_t adjoint_fma = jac.fma<Mode::ADJOINT>();
+         if (adjoint_fma < op.fma) {
+            op.mode = Mode::ADJOINT;
+            op.fma = adjoint_fma;
+         }
+      }
+
+      return op;
+   }
+
+   //! Appends the operations that may consume sub-chain (op_j, op_i) once
+   //! it was accumulated.
+   inline auto push_possible_eliminations(
+        const JacobianChain& chain, std::vector<OpPair>& eliminations,
+        const std::size_t op_j, const std::size_t op_i) -> void {
+      OpPair ops {};
+
+      // Tangent or multiplication
+      if (op_j < chain.length() - 1) {
+         const std::size_t k = op_j;
+         const std::size_t i = op_i;
+         const Jacobian& ki_jac = chain.get_jacobian(k, i);
+
+         // Add multiplication if possible
+         if (const auto j = chain.frontier_end(k + 1); j.has_value()) {
+            const Jacobian& jk_jac = chain.get_jacobian(j.value(), k + 1);
+            ops[0] = Operation {
+                 .action = Action::MULTIPLICATION,
+                 .j = j.value(),
+                 .k = k,
+                 .i = i,
+                 .fma = jk_jac.m * ki_jac.m * ki_jac.n};
+         } else if (m_matrix_free) {
+            // Add tangent elimination if multiplication wasn't possible
+            const std::size_t j = k + 1;
+            const Jacobian& jk_jac = chain.get_jacobian(j, k + 1);
+            assert(!jk_jac.is_accumulated && !jk_jac.is_used);
+
+            ops[0] = Operation {
+                 .action = Action::ELIMINATION,
+                 .mode = Mode::TANGENT,
+                 .j = j,
+                 .k = k,
+                 .i = i,
+                 .fma = jk_jac.fma<Mode::TANGENT>(ki_jac.n)};
+         }
+      }
+
+      // Adjoint or multiplication
+      if (op_i > 0) {
+         const std::size_t k = op_i - 1;
+         const std::size_t j = op_j;
+         const Jacobian& jk_jac = chain.get_jacobian(j, k + 1);
+
+         // Add multiplication if possible
+         if (const auto i = chain.frontier_start(k); i.has_value()) {
+            const Jacobian& ki_jac = chain.get_jacobian(k, i.value());
+            ops[1] = Operation {
+                 .action = Action::MULTIPLICATION,
+                 .j = j,
+                 .k = k,
+                 .i = i.value(),
+                 .fma = jk_jac.m * ki_jac.m * ki_jac.n};
+         } else if (m_matrix_free) {
+            // Add adjoint elimination if multiplication wasn't possible
+            const std::size_t i = k;
+            const Jacobian& ki_jac = chain.get_jacobian(k, i);
+            assert(!ki_jac.is_accumulated && !ki_jac.is_used);
+
+            if (m_available_memory == 0 ||
+                m_available_memory >= ki_jac.edges_in_dag) {
+               ops[1] = Operation {
+                    .action = Action::ELIMINATION,
+                    .mode = Mode::ADJOINT,
+                    .j = j,
+                    .k = k,
+                    .i = i,
+                    .fma = ki_jac.fma<Mode::ADJOINT>(jk_jac.m)};
+            }
+         }
+      }
+
+      eliminations.push_back(ops);
+   }
 };
 
 }  // end namespace jcdp::optimizer
@@ -0,0 +1,398 @@
+/******************************************************************************
+ * @file jcdp/optimizer/portfolio.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides an optimizer that
+ *        runs all other optimizers and schedulers concurrently on disjoint
+ *        sets of cores and shares their incumbent (portfolio).
+ ******************************************************************************/
+
+#ifndef JCDP_OPTIMIZER_PORTFOLIO_HPP_
+#define JCDP_OPTIMIZER_PORTFOLIO_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "jcdp/jacobian_chain.hpp"
+#include "jcdp/optimizer/beam_search.hpp"
+#include "jcdp/optimizer/branch_and_bound.hpp"
+#include "jcdp/optimizer/dynamic_programming.hpp"
+#include "jcdp/optimizer/local_search.hpp"
+#include "jcdp/optimizer/optimizer.hpp"
+#include "jcdp/scheduler/branch_and_bound.hpp"
+#include "jcdp/scheduler/priority_list.hpp"
+#include "jcdp/sequence.hpp"
+#include "jcdp/util/cancellation_token.hpp"
+#include "jcdp/util/improvement.hpp"
+#include "jcdp/util/timer.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::optimizer {
+
+/******************************************************************************
+ * @brief Runs several strategies for the same chain concurrently.
+ *
+ * DP and DP + list scheduling are solved first since they only take
+ * milliseconds. Their best sequence seeds all other strategies, which then
+ * run at the same time, each with its own share of the OpenMP threads:
+ * DP + branch & bound scheduling, branch & bound + list scheduling, branch &
+ * bound + branch & bound scheduling, local search and beam search + list
+ * scheduling.
+ *
+ * The makespan of the best sequence is shared live: the branch & bound
+ * optimizers and the beam search prune everything that can't beat it. All
+ * strategies are stopped as soon as it meets the lower bound derived from
+ * the DP solutions, or once branch & bound + branch & bound scheduling
+ * finished its search (which proves it optimal), or once the time is up.
+ * The result is the best sequence, on ties the one that was found first.
+ ******************************************************************************/
+class PortfolioOptimizer : public Optimizer,
+                           public util::Timer,
+                           public util::ImprovementNotifier {
+ public:
+   PortfolioOptimizer() : Optimizer() {
+      register_property(
+           m_time_to_solve, "time_to_solve",
+           "Maximal runtime for the portfolio in seconds, shared by all of "
+           "its strategies.");
+
+      m_bnb_list_solver.set_parent_token(&m_stop);
+      m_bnb_solver.set_parent_token(&m_stop);
+      m_ls_solver.set_parent_token(&m_stop);
+      m_beam_solver.set_parent_token(&m_stop);
+
+      m_bnb_list_solver.set_shared_makespan(&m_shared_makespan);
+      m_bnb_solver.set_shared_makespan(&m_shared_makespan);
+      m_beam_solver.set_shared_makespan(&m_shared_makespan);
+   }
+
+   virtual ~PortfolioOptimizer() = default;
+
+   //! Parses the properties of the portfolio and of all of its strategies
+   //! from one config file. Unknown keys are skipped.
+   auto parse_configs(const std::filesystem::path& config_filename) -> void {
+      parse_config(config_filename, true);
+      m_dp_solver.parse_config(config_filename, true);
+      m_dp_bound_solver.parse_config(config_filename, true);
+      m_bnb_list_solver.parse_config(config_filename, true);
+      m_bnb_solver.parse_config(config_filename, true);
+      m_ls_solver.parse_config(config_filename, true);
+      m_beam_solver.parse_config(config_filename, true);
+
+      // The lower bound needs the DP solution for unlimited threads. Worker
+      // processes can't be forked while the strategies run as threads.
+      std::istringstream unlimited("available_threads 0");
+      m_dp_bound_solver.parse_config(unlimited);
+      std::istringstream bnb_list_config("processes 1");
+      m_bnb_list_solver.parse_config(bnb_list_config);
+      std::istringstream bnb_config("processes 1");
+      m_bnb_solver.parse_config(bnb_config);
+   }
+
+   virtual auto init(const JacobianChain& chain) -> void override final {
+      Optimizer::init(chain);
+
+      configure_scheduler(*m_list_scheduler);
+      configure_scheduler(*m_bnb_scheduler);
+
+      m_dp_solver.init(chain);
+      m_dp_bound_solver.init(chain);
+      m_bnb_list_solver.init(chain, m_list_scheduler);
+      m_bnb_solver.init(chain, m_bnb_scheduler);
+      m_ls_solver.init(chain);
+      m_beam_solver.init(chain, m_list_scheduler);
+
+      m_optimal_sequence.assign_max();
+      m_lower_bound = 0;
+      m_proven_optimal = false;
+      m_timer_expired = false;
+      m_strategies.clear();
+   }
+
+   virtual auto solve() -> Sequence override final {
+      start_timer();
+      m_stop.start();
+      m_shared_makespan.store(std::numeric_limits<std::size_t>::max());
+      m_strategies.clear();
+
+      // DP solutions for the seed and the lower bound
+      Sequence dp_seq = m_dp_solver.solve();
+      m_lower_bound = m_dp_bound_solver.solve().makespan();
+      if (m_usable_threads > 0) {
+         const std::size_t sequential_makespan =
+              m_dp_solver.get_sequence(1).makespan();
+         m_lower_bound = std::max(
+              m_lower_bound,
+              (sequential_makespan + m_usable_threads - 1) /
+                   m_usable_threads);
+      }
+      // The DP schedules itself, so memory limits and transfer costs are
+      // only taken into account afterwards
+      Sequence dp_fit_seq = dp_seq;
+      m_list_scheduler->retime(dp_fit_seq);
+      Strategy& dp = add_strategy("DP", 1);
+      finish(dp, dp_fit_seq, true);
+
+      Sequence dp_list_seq = dp_seq;
+      m_list_scheduler->schedule(dp_list_seq, m_usable_threads);
+      Strategy& dp_list = add_strategy("DP + List scheduling", 1);
+      finish(dp_list, dp_list_seq, true);
+
+      Sequence seed = (dp_list_seq.makespan() < dp_fit_seq.makespan())
+                           ? dp_list_seq
+                           : dp_fit_seq;
+
+      if (!m_proven_optimal) {
+         // Partition the cores. DP + B&B scheduling is sequential, the rest
+         // is spread evenly (branch & bound + B&B scheduling first).
+         std::size_t cores = 1;
+#if defined(_OPENMP)
+         cores = static_cast<std::size_t>(omp_get_max_threads());
+#endif
+         std::vector<std::size_t> shares(4, 1);
+         for (std::size_t c = shares.size() + 1; c < cores; ++c) {
+            shares[(c - shares.size() - 1) % shares.size()]++;
+         }
+
+         Strategy& dp_bnb = add_strategy("DP + B&B scheduling", 1);
+         Strategy& bnb = add_strategy("BnB + B&B scheduling", shares[0]);
+         Strategy& bnb_list = add_strategy(
+              "BnB + List scheduling", shares[1]);
+         Strategy& beam = add_strategy(
+              "Beam search + List scheduling", shares[2]);
+         Strategy& ls = add_strategy("Local search", shares[3]);
+
+         m_bnb_solver.set_incumbent(seed);
+         m_bnb_solver.set_lower_bound(m_lower_bound);
+         m_bnb_solver.set_guide(dp_seq);
+         m_bnb_list_solver.set_incumbent(seed);
+         m_bnb_list_solver.set_lower_bound(m_lower_bound);
+         m_bnb_list_solver.set_guide(dp_seq);
+         m_beam_solver.set_incumbent(seed);
+         m_ls_solver.set_incumbent(seed);
+         m_ls_solver.set_lower_bound(m_lower_bound);
+
+         report_improvements(m_bnb_solver, bnb);
+         report_improvements(m_bnb_list_solver, bnb_list);
+         report_improvements(m_beam_solver, beam);
+
+         // So does the local search, its improvements are only final once
+         // it finished.
+         if (!m_list_scheduler->is_memory_aware() &&
+             !m_list_scheduler->is_communication_aware()) {
+            report_improvements(m_ls_solver, ls);
+         }
+
+         std::vector<std::jthread> threads;
+         threads.emplace_back(run(dp_bnb, [&]() -> void {
+            Sequence sequence = seed;
+            util::CancellationToken token(&m_stop);
+            token.start();
+            const std::size_t upper_bound = std::min(
+                 sequence.makespan(), m_shared_makespan.load());
+            if (m_bnb_scheduler->schedule(
+                     sequence, m_usable_threads, upper_bound, token) <
+                upper_bound) {
+               finish(dp_bnb, sequence, !token.is_cancelled());
+            } else {
+               finish(dp_bnb, seed, !token.is_cancelled());
+            }
+         }));
+         threads.emplace_back(run(bnb, [&]() -> void {
+            Sequence sequence = m_bnb_solver.solve();
+            finish(bnb, sequence, m_bnb_solver.finished_in_time());
+
+            // The search is exhaustive, so the best makespan is optimal
+            if (m_bnb_solver.finished_in_time()) {
+               std::lock_guard<std::mutex> lock(m_mutex);
+               m_proven_optimal = true;
+               m_stop.cancel();
+            }
+         }));
+         threads.emplace_back(run(bnb_list, [&]() -> void {
+            Sequence sequence = m_bnb_list_solver.solve();
+            finish(bnb_list, sequence, m_bnb_list_solver.finished_in_time());
+         }));
+         threads.emplace_back(run(beam, [&]() -> void {
+            Sequence sequence = m_beam_solver.solve();
+            finish(beam, sequence, m_beam_solver.finished_in_time());
+         }));
+         threads.emplace_back(run(ls, [&]() -> void {
+            Sequence sequence = m_ls_solver.solve();
+            m_list_scheduler->retime(sequence);
+            finish(ls, sequence, m_ls_solver.finished_in_time());
+         }));
+      }
+
+      // Best sequence, on ties the one that was found first
+      const Strategy* best = &m_strategies.front();
+      for (const Strategy& strategy : m_strategies) {
+         if (std::tie(strategy.makespan, strategy.found_time) <
+             std::tie(best->makespan, best->found_time)) {
+            best = &strategy;
+         }
+      }
+      m_optimal_sequence = best->sequence;
+      m_best_strategy = best->name;
+
+      if (!m_proven_optimal) {
+         remaining_time();
+      }
+      return m_optimal_sequence;
+   }
+
+   //! Lower bound from the DP solutions of the last solve.
+   inline auto lower_bound() const -> std::size_t {
+      return m_lower_bound;
+   }
+
+   //! Whether the result of the last solve is known to be optimal.
+   inline auto proven_optimal() const -> bool {
+      return m_proven_optimal;
+   }
+
+   inline auto print_stats() -> void {
+      std::println("Lower bound: {}", m_lower_bound);
+      std::println("Proven optimal: {}", m_proven_optimal);
+      std::println("Best strategy: {}", m_best_strategy);
+      for (const Strategy& strategy : m_strategies) {
+         std::println(
+              "{:>30}: threads {}, makespan {}, found after {} s, solved "
+              "after {} s{}",
+              strategy.name, strategy.threads, strategy.makespan,
+              strategy.found_time, strategy.solve_time,
+              strategy.finished ? "" : " (stopped)");
+      }
+   }
+
+ private:
+   //! Result of one strategy of the portfolio.
+   struct Strategy {
+      std::string name {};
+      std::size_t threads {1};
+      Sequence sequence {Sequence::make_max()};
+      std::size_t makespan {std::numeric_limits<std::size_t>::max()};
+
+      // Time when the makespan was reached and when the strategy returned
+      double found_time {std::numeric_limits<double>::max()};
+      double solve_time {0};
+      bool finished {false};
+   };
+
+   DynamicProgrammingOptimizer m_dp_solver {};
+   DynamicProgrammingOptimizer m_dp_bound_solver {};
+   BranchAndBoundOptimizer m_bnb_list_solver {};
+   BranchAndBoundOptimizer m_bnb_solver {};
+   LocalSearchOptimizer m_ls_solver {};
+   BeamSearchOptimizer m_beam_solver {};
+   std::shared_ptr<scheduler::PriorityListScheduler> m_list_scheduler {
+        std::make_shared<scheduler::PriorityListScheduler>()};
+   std::shared_ptr<scheduler::BranchAndBoundScheduler> m_bnb_scheduler {
+        std::make_shared<scheduler::BranchAndBoundScheduler>()};
+
+   // Stops all strategies at once, either with the timer or if the
+   // incumbent is proven optimal.
+   util::CancellationToken m_stop {&m_token};
+
+   std::mutex m_mutex {};
+   std::atomic<std::size_t> m_shared_makespan {
+        std::numeric_limits<std::size_t>::max()};
+   std::vector<Strategy> m_strategies {};
+   Sequence m_optimal_sequence {Sequence::make_max()};
+   std::string m_best_strategy {};
+   std::size_t m_lower_bound {0};
+   bool m_proven_optimal {false};
+
+   //! The strategies are only added before the threads start, so the
+   //! references stay valid.
+   inline auto add_strategy(const std::string& name, std::size_t threads)
+        -> Strategy& {
+      if (m_strategies.empty()) {
+         m_strategies.reserve(7);
+      }
+      assert(m_strategies.size() < m_strategies.capacity());
+      return m_strategies.emplace_back(Strategy {
+           .name = name, .threads = threads});
+   }
+
+   //! Wraps a strategy for a thread that uses its share of the cores.
+   inline auto run(const Strategy& strategy, std::function<void()> body)
+        -> std::function<void()> {
+      return [threads = strategy.threads, body = std::move(body)]() -> void {
+#if defined(_OPENMP)
+         omp_set_num_threads(static_cast<int>(threads));
+#endif
+         body();
+      };
+   }
+
+   //! Forwards the improvements of a solver to the shared incumbent.
+   template<typename Solver>
+   inline auto report_improvements(Solver& solver, Strategy& strategy)
+        -> void {
+      solver.on_improvement([this, &strategy](const util::Improvement& imp) {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         improve(strategy, imp.makespan);
+      });
+   }
+
+   //! Stores the final sequence of a strategy.
+   inline auto finish(
+        Strategy& strategy, Sequence sequence, const bool finished) -> void {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      strategy.solve_time = elapsed_time();
+      strategy.finished = finished;
+      if (sequence.makespan() <= strategy.makespan) {
+         improve(strategy, sequence.makespan());
+         strategy.sequence = std::move(sequence);
+      }
+   }
+
+   //! Updates the makespan of a strategy and the shared incumbent. Stops
+   //! all strategies once the lower bound is met. Requires m_mutex.
+   inline auto improve(Strategy& strategy, const std::size_t makespan)
+        -> void {
+      if (makespan < strategy.makespan) {
+         strategy.makespan = makespan;
+         strategy.found_time = elapsed_time();
+      }
+
+      if (makespan < m_shared_makespan.load()) {
+         m_shared_makespan.store(makespan);
+         notify_improvement({
+              .makespan = makespan,
+              .lower_bound = m_lower_bound,
+              .threads = m_usable_threads,
+              .elapsed_time = elapsed_time()});
+      }
+
+      if (makespan <= m_lower_bound) {
+         m_proven_optimal = true;
+         m_stop.cancel();
+      }
+   }
+};
+
+}  // end namespace jcdp::optimizer
+
+#endif  // JCDP_OPTIMIZER_PORTFOLIO_HPP_
@@ -13,25 +13,31 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <optional>
 #include <print>
 #include <vector>
 
 #include "jcdp/operation.hpp"
 #include "jcdp/scheduler/scheduler.hpp"
 #include "jcdp/sequence.hpp"
+#include "jcdp/util/cancellation_token.hpp"
+#include "jcdp/util/improvement.hpp"
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
 namespace jcdp::scheduler {
 
-class BranchAndBoundScheduler : public Scheduler {
+class BranchAndBoundScheduler : public Scheduler,
+                                public util::ImprovementNotifier {
  public:
    virtual auto schedule_impl(
         Sequence& sequence, const std::size_t usable_threads,
-        const std::size_t upper_bound) -> std::size_t override final {
+        const std::size_t upper_bound, util::CancellationToken& token)
+        -> std::size_t override final {
       const std::size_t sequential_makespan = sequence.sequential_makespan();
 
       Sequence working_copy = sequence;
+      Sequence repaired {};
       std::size_t best_makespan = upper_bound;
 
       std::vector<std::size_t> thread_loads(usable_threads, 0);
@@ -49,9 +55,14 @@ class BranchAndBoundScheduler : public Scheduler {
          return lower_bound;
       }
 
+      // Only used for reporting improvements
+      const std::size_t load_bound = std::max(
+           lower_bound,
+           (sequential_makespan + usable_threads - 1) / usable_threads);
+
       auto schedule_op = [&](auto& schedule_next_op) -> bool {
-         // Return if time's up
-         if (!remaining_time()) {
+         // Return if time's up or the token was cancelled
+         if (!token.poll()) {
             return true;
          }
 
@@ -67,16 +78,23 @@ class BranchAndBoundScheduler : public Scheduler {
             }
 
             working_copy[op_idx].is_scheduled = true;
-            bool tried_empty_processor = false;
-            const std::size_t start = working_copy.earliest_start(op_idx);
+            std::optional<std::size_t> tried_empty_domain;
+            const std::size_t ready = working_copy.earliest_start(op_idx);
 
             for (size_t t = 0; t < usable_threads; t++) {
-               // We only need to check one empty processor (w.l.o.g.)
+               // We only need to check one empty processor per NUMA domain
+               // (w.l.o.g.)
                if (thread_loads[t] == 0) {
-                  if (tried_empty_processor) {
-                     break;
+                  if (tried_empty_domain == domain(t)) {
+                     continue;
                   }
-                  tried_empty_processor = true;
+                  tried_empty_domain = domain(t);
+               }
+
+               // With transfer costs, the operands arrive at different times
+               std::size_t start = ready;
+               if (is_communication_aware()) {
+                  start = earliest_start(working_copy, op_idx, t);
                }
 
                const std::size_t old_start_time =
@@ -115,13 +133,30 @@ class BranchAndBoundScheduler : public Scheduler {
          }
 
          if (everything_scheduled) {
-            if (makespan < best_makespan) {
-               best_makespan = makespan;
+            // With memory limits, schedules compete by their makespan after
+            // the repair. It only delays operations, so the bounds hold.
+            const Sequence* leaf = &working_copy;
+            std::size_t leaf_makespan = makespan;
+            if (is_memory_aware() && makespan < best_makespan) {
+               repaired = working_copy;
+               leaf_makespan = repaired_makespan(repaired, makespan);
+               leaf = &repaired;
+            }
+
+            if (leaf_makespan < best_makespan) {
+               best_makespan = leaf_makespan;
                for (size_t i = 0; i < sequence.length(); ++i) {
-                  sequence[i].thread = working_copy[i].thread;
-                  sequence[i].start_time = working_copy[i].start_time;
+                  sequence[i].thread = (*leaf)[i].thread;
+                  sequence[i].start_time = (*leaf)[i].start_time;
                   sequence[i].is_scheduled = true;
                }
+
+               notify_improvement({
+                    .makespan = best_makespan,
+                    .lower_bound = load_bound,
+                    .threads = usable_threads,
+                    .elapsed_time = token.elapsed_time()});
+
                if (best_makespan <= lower_bound) {
                   return true;
                }
@@ -134,6 +169,11 @@ class BranchAndBoundScheduler : public Scheduler {
       schedule_op(schedule_op);
       return best_makespan;
    }
+
+ protected:
+   virtual auto is_repairing() const -> bool override final {
+      return true;
+   }
 };
 
 }  // namespace jcdp::scheduler
@@ -0,0 +1,150 @@
+/******************************************************************************
+ * @file jcdp/scheduler/communication.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides a cost model for
+ *        moving Jacobians between threads: an operation whose operand was
+ *        produced on another thread can only start once the operand has been
+ *        transferred, which takes longer across NUMA domains.
+ ******************************************************************************/
+
+#ifndef JCDP_SCHEDULER_COMMUNICATION_HPP_
+#define JCDP_SCHEDULER_COMMUNICATION_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "jcdp/jacobian.hpp"
+#include "jcdp/jacobian_chain.hpp"
+#include "jcdp/operation.hpp"
+#include "jcdp/sequence.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::scheduler {
+
+class CommunicationModel {
+ public:
+   //! Transfer costs are given as latency and cost per Jacobian entry (in
+   //! fma), within a NUMA domain and across domains. The domains list the
+   //! amount of threads per domain, threads beyond the last domain belong
+   //! to it as well. Only the sizes of the elementals are kept.
+   CommunicationModel(
+        const JacobianChain& chain,
+        const std::pair<std::size_t, double> transfer_cost,
+        const std::pair<std::size_t, double> numa_transfer_cost,
+        const std::vector<std::size_t>& domains) {
+      assign(chain, transfer_cost, numa_transfer_cost, domains);
+   }
+
+   //! Switches to another chain and other costs, e.g. for the next chain of
+   //! a batch, and reuses the storage.
+   inline auto assign(
+        const JacobianChain& chain,
+        const std::pair<std::size_t, double> transfer_cost,
+        const std::pair<std::size_t, double> numa_transfer_cost,
+        const std::vector<std::size_t>& domains) -> void {
+      m_transfer_cost = transfer_cost;
+      m_numa_transfer_cost = numa_transfer_cost;
+
+      m_domains.clear();
+      for (std::size_t d = 0; d < domains.size(); ++d) {
+         m_domains.insert(m_domains.end(), domains[d], d);
+      }
+
+      m_rows.clear();
+      m_columns.clear();
+      for (const Jacobian& jac : chain.elemental_jacobians) {
+         m_rows.push_back(jac.m);
+         m_columns.push_back(jac.n);
+      }
+   }
+
+   //! NUMA domain of a thread.
+   inline auto domain(const std::size_t thread) const -> std::size_t {
+      if (m_domains.empty()) {
+         return 0;
+      }
+      return m_domains[std::min(thread, m_domains.size() - 1)];
+   }
+
+   //! Time to move the Jacobian produced by op from one thread to another.
+   inline auto transfer(
+        const Operation& op, const std::size_t from,
+        const std::size_t to) const -> std::size_t {
+      if (from == to) {
+         return 0;
+      }
+
+      const std::size_t entries = m_rows[op.j] * m_columns[op.i];
+      const auto& [latency, cost] = (domain(from) == domain(to))
+                                         ? m_transfer_cost
+                                         : m_numa_transfer_cost;
+      return latency + static_cast<std::size_t>(std::ceil(
+                            cost * static_cast<double>(entries)));
+   }
+
+   //! Earliest start of an operation on the given thread, i.e. once all of
+   //! its operands are produced and transferred to the thread.
+   inline auto earliest_start(
+        const Sequence& sequence, const std::size_t op_idx,
+        const std::size_t thread) const -> std::size_t {
+      std::size_t start = 0;
+      for (std::size_t i = 0; i < sequence.length(); ++i) {
+         const Operation& op = sequence[i];
+         if (sequence[op_idx] < op) {
+            const std::size_t arrival = op.start_time + op.fma +
+                                        transfer(op, op.thread, thread);
+            start = std::max(start, arrival);
+         }
+      }
+      return start;
+   }
+
+   //! Re-times a complete schedule (e.g. one an optimizer made itself) so
+   //! that operands are transferred before they are used. The operations
+   //! keep their threads and their order. Returns the new makespan.
+   inline auto retime(Sequence& sequence) const -> std::size_t {
+      std::vector<std::size_t> order(sequence.length());
+      std::iota(order.begin(), order.end(), 0);
+      std::ranges::stable_sort(
+           order, {}, [&sequence](const std::size_t idx) noexcept {
+              return std::pair(sequence[idx].start_time, sequence[idx].fma);
+           });
+
+      std::vector<std::size_t> thread_loads;
+      std::size_t makespan = 0;
+      for (const std::size_t op_idx : order) {
+         Operation& op = sequence[op_idx];
+         if (thread_loads.size() <= op.thread) {
+            thread_loads.resize(op.thread + 1, 0);
+         }
+
+         op.start_time = std::max(
+              thread_loads[op.thread],
+              earliest_start(sequence, op_idx, op.thread));
+         thread_loads[op.thread] = op.start_time + op.fma;
+         makespan = std::max(makespan, thread_loads[op.thread]);
+      }
+
+      return makespan;
+   }
+
+ private:
+   std::pair<std::size_t, double> m_transfer_cost {};
+   std::pair<std::size_t, double> m_numa_transfer_cost {};
+   std::vector<std::size_t> m_domains {};
+
+   // Rows and columns of the elementals
+   std::vector<std::size_t> m_rows {};
+   std::vector<std::size_t> m_columns {};
+};
+
+}  // namespace jcdp::scheduler
+
+#endif  // JCDP_SCHEDULER_COMMUNICATION_HPP_
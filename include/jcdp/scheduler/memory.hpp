@@ -0,0 +1,318 @@
+/******************************************************************************
+ * @file jcdp/scheduler/memory.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides a memory model
+ *        for schedules: adjoint operations keep their tape alive while they
+ *        run and every Jacobian is stored from the start of the operation
+ *        that produces it until the end of the operation that consumes it.
+ ******************************************************************************/
+
+#ifndef JCDP_SCHEDULER_MEMORY_HPP_
+#define JCDP_SCHEDULER_MEMORY_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <algorithm>
+#include <functional>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <vector>
+
+#include "jcdp/jacobian.hpp"
+#include "jcdp/jacobian_chain.hpp"
+#include "jcdp/operation.hpp"
+#include "jcdp/scheduler/communication.hpp"
+#include "jcdp/sequence.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::scheduler {
+
+class MemoryModel {
+ public:
+   //! Memory limits are given per thread and for all threads together. A
+   //! limit of zero means unlimited. Only the sizes of the elementals are
+   //! kept, the chain may change afterwards.
+   MemoryModel(
+        const JacobianChain& chain, const std::size_t thread_memory,
+        const std::size_t node_memory) {
+      assign(chain, thread_memory, node_memory);
+   }
+
+   //! Switches to another chain and other limits, e.g. for the next chain
+   //! of a batch, and reuses the storage.
+   inline auto assign(
+        const JacobianChain& chain, const std::size_t thread_memory,
+        const std::size_t node_memory) -> void {
+      m_thread_memory = thread_memory;
+      m_node_memory = node_memory;
+
+      m_rows.clear();
+      m_columns.clear();
+      m_edges.assign(1, 0);
+      for (const Jacobian& jac : chain.elemental_jacobians) {
+         m_rows.push_back(jac.m);
+         m_columns.push_back(jac.n);
+         m_edges.push_back(m_edges.back() + jac.edges_in_dag);
+      }
+   }
+
+   //! Size of the tape an operation records (adjoint operations only).
+   inline auto tape(const Operation& op) const -> std::size_t {
+      if (op.mode != Mode::ADJOINT) {
+         return 0;
+      }
+
+      if (op.action == Action::ACCUMULATION) {
+         return m_edges[op.j + 1] - m_edges[op.i];
+      }
+      return m_edges[op.k + 1] - m_edges[op.i];
+   }
+
+   //! Size of the (dense) Jacobian an operation produces.
+   inline auto jacobian(const Operation& op) const -> std::size_t {
+      return m_rows[op.j] * m_columns[op.i];
+   }
+
+   //! Re-times a complete schedule so that it respects the memory limits.
+   //! The operations keep their threads and are placed in the order of
+   //! their previous start times, each at the earliest time at which its
+   //! tape and its Jacobian fit. If that deadlocks, all operations are
+   //! placed on a single thread in the post-order that keeps the fewest
+   //! Jacobians alive. Returns the new makespan. If neither fits, the
+   //! sequence becomes the maximum sequence (see Sequence::assign_max).
+   //! Operands are transferred between threads if a model is given.
+   inline auto repair(
+        Sequence& sequence,
+        const CommunicationModel* communication = nullptr) const
+        -> std::size_t {
+      const std::size_t length = sequence.length();
+
+      std::vector<std::size_t> order(length);
+      std::iota(order.begin(), order.end(), 0);
+      std::ranges::stable_sort(
+           order, [&sequence](const std::size_t lhs, const std::size_t rhs)
+                       noexcept {
+              const Operation& l_op = sequence[lhs];
+              const Operation& r_op = sequence[rhs];
+              if (l_op.start_time == r_op.start_time) {
+                 return l_op.fma < r_op.fma;
+              }
+              return l_op.start_time < r_op.start_time;
+           });
+
+      std::vector<std::size_t> threads(length);
+      for (std::size_t op_idx = 0; op_idx < length; ++op_idx) {
+         threads[op_idx] = sequence[op_idx].thread;
+      }
+
+      const std::size_t makespan = place(
+           sequence, order, threads, communication);
+      if (makespan != INFINITE) {
+         return makespan;
+      }
+
+      order.clear();
+      for (std::size_t op_idx = 0; op_idx < length; ++op_idx) {
+         if (!sequence.parent(op_idx).has_value()) {
+            post_order(sequence, op_idx, order);
+         }
+      }
+      const std::vector<std::size_t> single_thread(length, 0);
+      if (place(sequence, order, single_thread, communication) == INFINITE) {
+         sequence.assign_max();
+      }
+      return sequence.makespan();
+   }
+
+ private:
+   static constexpr std::size_t INFINITE = std::numeric_limits<
+        std::size_t>::max();
+
+   struct Allocation {
+      std::size_t thread;
+      std::size_t begin;
+      std::size_t end;
+      std::size_t amount;
+   };
+
+   std::size_t m_thread_memory {0};
+   std::size_t m_node_memory {0};
+
+   // Rows and columns of the elementals, edges of the DAGs of the first i
+   std::vector<std::size_t> m_rows {};
+   std::vector<std::size_t> m_columns {};
+   std::vector<std::size_t> m_edges {};
+
+   //! Appends the subtree of op_idx in post-order and returns the memory it
+   //! needs when run sequentially. As for register allocation, the child
+   //! that needs the most on top of its own Jacobian goes first.
+   inline auto post_order(
+        const Sequence& sequence, const std::size_t op_idx,
+        std::vector<std::size_t>& order) const -> std::size_t {
+      struct Subtree {
+         std::size_t excess;
+         std::size_t need;
+         std::size_t jacobian;
+         std::vector<std::size_t> order;
+      };
+
+      std::vector<Subtree> subtrees;
+      for (const std::size_t child_idx : sequence.children(op_idx)) {
+         Subtree& subtree = subtrees.emplace_back();
+         subtree.need = post_order(sequence, child_idx, subtree.order);
+         subtree.jacobian = jacobian(sequence[child_idx]);
+         subtree.excess = subtree.need - std::min(
+                                              subtree.need, subtree.jacobian);
+      }
+      std::ranges::stable_sort(
+           subtrees, std::ranges::greater(), &Subtree::excess);
+
+      std::size_t need = 0;
+      std::size_t stored = 0;
+      for (const Subtree& subtree : subtrees) {
+         order.insert(order.end(), subtree.order.begin(), subtree.order.end());
+         need = std::max(need, subtree.need + stored);
+         stored += subtree.jacobian;
+      }
+
+      order.push_back(op_idx);
+      const Operation& op = sequence[op_idx];
+      return std::max(need, stored + tape(op) + jacobian(op));
+   }
+
+   //! Places the operations in the given order on the given threads, each
+   //! at the earliest time at which it fits. The sequence is only updated
+   //! if all of them fit.
+   inline auto place(
+        Sequence& sequence, const std::vector<std::size_t>& order,
+        const std::vector<std::size_t>& threads_of,
+        const CommunicationModel* communication) const -> std::size_t {
+      const std::size_t length = sequence.length();
+      std::vector<std::size_t> start_times(length);
+
+      std::size_t threads = 0;
+      for (const std::size_t thread : threads_of) {
+         threads = std::max(threads, thread + 1);
+      }
+
+      std::vector<Allocation> allocations;
+      std::vector<std::optional<std::size_t>> outputs(length);
+      std::vector<std::size_t> end_times(length, 0);
+      std::vector<std::size_t> thread_loads(threads, 0);
+
+      std::size_t makespan = 0;
+      for (const std::size_t op_idx : order) {
+         const Operation& op = sequence[op_idx];
+         const std::size_t thread = threads_of[op_idx];
+         const std::vector<std::size_t> children = sequence.children(op_idx);
+
+         std::size_t ready = thread_loads[thread];
+         for (const std::size_t child_idx : children) {
+            std::size_t arrival = end_times[child_idx];
+            if (communication != nullptr) {
+               arrival += communication->transfer(
+                    sequence[child_idx], threads_of[child_idx], thread);
+            }
+            ready = std::max(ready, arrival);
+         }
+
+         // Memory is only released at the end of an allocation, so these are
+         // the only start times worth trying.
+         std::vector<std::size_t> candidates {ready};
+         for (const Allocation& alloc : allocations) {
+            if (alloc.end > ready && alloc.end != INFINITE) {
+               candidates.push_back(alloc.end);
+            }
+         }
+         std::ranges::sort(candidates);
+
+         std::optional<std::size_t> start;
+         for (const std::size_t candidate : candidates) {
+            if (fits(allocations, outputs, children, op, thread, candidate)) {
+               start = candidate;
+               break;
+            }
+         }
+
+         if (!start.has_value()) {
+            return INFINITE;
+         }
+
+         start_times[op_idx] = start.value();
+         end_times[op_idx] = start_times[op_idx] + op.fma;
+         thread_loads[thread] = end_times[op_idx];
+         makespan = std::max(makespan, end_times[op_idx]);
+
+         // The inputs are freed once the operation has consumed them
+         for (const std::size_t child_idx : children) {
+            if (outputs[child_idx].has_value()) {
+               allocations[outputs[child_idx].value()].end = end_times[op_idx];
+            }
+         }
+
+         if (tape(op) > 0) {
+            allocations.push_back(
+                 {thread, start_times[op_idx], end_times[op_idx], tape(op)});
+         }
+         outputs[op_idx] = allocations.size();
+         allocations.push_back(
+              {thread, start_times[op_idx], INFINITE, jacobian(op)});
+      }
+
+      for (std::size_t op_idx = 0; op_idx < length; ++op_idx) {
+         sequence[op_idx].thread = threads_of[op_idx];
+         sequence[op_idx].start_time = start_times[op_idx];
+      }
+
+      return makespan;
+   }
+
+   //! Checks whether op fits if it starts at the given time. Since usage
+   //! only grows at the beginning of an allocation, it suffices to check the
+   //! start time and every later allocation begin.
+   inline auto fits(
+        std::vector<Allocation> allocations,
+        const std::vector<std::optional<std::size_t>>& outputs,
+        const std::vector<std::size_t>& children, const Operation& op,
+        const std::size_t thread, const std::size_t start) const -> bool {
+      const std::size_t end = start + op.fma;
+      for (const std::size_t child_idx : children) {
+         if (outputs[child_idx].has_value()) {
+            allocations[outputs[child_idx].value()].end = end;
+         }
+      }
+      allocations.push_back({thread, start, end, tape(op)});
+      allocations.push_back({thread, start, INFINITE, jacobian(op)});
+
+      for (const Allocation& point : allocations) {
+         if (point.begin < start) {
+            continue;
+         }
+
+         std::size_t thread_usage = 0;
+         std::size_t node_usage = 0;
+         for (const Allocation& alloc : allocations) {
+            if (alloc.begin <= point.begin && point.begin < alloc.end) {
+               node_usage += alloc.amount;
+               if (alloc.thread == thread) {
+                  thread_usage += alloc.amount;
+               }
+            }
+         }
+
+         if ((m_thread_memory > 0 && thread_usage > m_thread_memory) ||
+             (m_node_memory > 0 && node_usage > m_node_memory)) {
+            return false;
+         }
+      }
+
+      return true;
+   }
+};
+
+}  // namespace jcdp::scheduler
+
+#endif  // JCDP_SCHEDULER_MEMORY_HPP_
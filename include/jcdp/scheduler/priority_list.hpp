@@ -23,6 +23,7 @@
 #include "jcdp/operation.hpp"
 #include "jcdp/scheduler/scheduler.hpp"
 #include "jcdp/sequence.hpp"
+#include "jcdp/util/cancellation_token.hpp"
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
@@ -31,8 +32,8 @@ namespace jcdp::scheduler {
 class PriorityListScheduler : public Scheduler {
  public:
    virtual auto schedule_impl(
-        Sequence& sequence, const std::size_t usable_threads, const std::size_t)
-        -> std::size_t override final {
+        Sequence& sequence, const std::size_t usable_threads, const std::size_t,
+        util::CancellationToken&) -> std::size_t override final {
 
       std::vector<std::size_t> queue_cont(sequence.length());
       std::iota(queue_cont.begin(), queue_cont.end(), 0);
@@ -57,16 +58,24 @@ class PriorityListScheduler : public Scheduler {
       std::vector<std::size_t> thread_loads(usable_threads, 0);
       while (!queue.empty()) {
          const std::size_t op_idx = queue.top();
-         const std::size_t earliest_start = sequence.earliest_start(op_idx);
+         const std::size_t ready = sequence.earliest_start(op_idx);
+
+         // With transfer costs, the operands arrive at different times
+         auto earliest_start_on = [&](const std::size_t t) -> std::size_t {
+            if (is_communication_aware()) {
+               return earliest_start(sequence, op_idx, t);
+            }
+            return ready;
+         };
 
          Operation& op = sequence[op_idx];
          op.thread = 0;
-         op.start_time = std::max(thread_loads[0], earliest_start);
+         op.start_time = std::max(thread_loads[0], earliest_start_on(0));
          std::size_t current_idle_time = op.start_time - thread_loads[0];
 
          for (size_t t = 1; t < usable_threads; t++) {
             const std::size_t start_on_t = std::max(
-                 thread_loads[t], earliest_start);
+                 thread_loads[t], earliest_start_on(t));
             const std::size_t idle_on_t = start_on_t - thread_loads[t];
 
             if (start_on_t < op.start_time) {
@@ -13,9 +13,16 @@
 
 #include <cstddef>
 #include <limits>
+#include <memory>
 #include <print>
+#include <utility>
+#include <vector>
 
+#include "jcdp/jacobian_chain.hpp"
+#include "jcdp/scheduler/communication.hpp"
+#include "jcdp/scheduler/memory.hpp"
 #include "jcdp/sequence.hpp"
+#include "jcdp/util/cancellation_token.hpp"
 #include "jcdp/util/timer.hpp"
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
@@ -31,8 +38,25 @@ class Scheduler : public util::Timer {
         Sequence& sequence, const std::size_t threads,
         const std::size_t upper_bound = std::numeric_limits<std::size_t>::max())
         -> std::size_t {
-
       start_timer();
+      const std::size_t makespan = schedule(
+           sequence, threads, upper_bound, m_token);
+      m_timer_expired |= m_token.is_cancelled();
+      return makespan;
+   }
+
+   //! Schedules the sequence and stops once the given token is cancelled.
+   //! Doesn't touch the timer of the scheduler, so one scheduler may be
+   //! used by multiple tasks at once, each with its own token.
+   inline auto schedule(
+        Sequence& sequence, const std::size_t threads,
+        const std::size_t upper_bound, util::CancellationToken& token)
+        -> std::size_t {
+
+      // Nothing to schedule if the sequence never fits into memory
+      if (sequence.is_max()) {
+         return sequence.makespan();
+      }
 
       // We can never use more threads than we have accumulations
       std::size_t usable_threads = sequence.count_accumulations();
@@ -40,11 +64,131 @@ class Scheduler : public util::Timer {
          usable_threads = threads;
       }
 
-      return schedule_impl(sequence, usable_threads, upper_bound);
+      const std::size_t makespan = schedule_impl(
+           sequence, usable_threads, upper_bound, token);
+
+      // Delay the operations until they fit into memory. Only a schedule
+      // that beats the upper bound was written to the sequence, and it may
+      // no longer beat it afterwards.
+      if (m_memory_model && !is_repairing() && makespan < upper_bound &&
+          sequence.is_scheduled()) {
+         return m_memory_model->repair(sequence, m_communication_model.get());
+      }
+
+      return makespan;
+   }
+
+   //! Re-times an already scheduled sequence (e.g. one that was scheduled
+   //! by an optimizer itself) so that it respects the memory limits and
+   //! transfer costs. A sequence that never fits into memory becomes the
+   //! maximum sequence.
+   inline auto retime(Sequence& sequence) const -> std::size_t {
+      if (m_memory_model) {
+         return m_memory_model->repair(sequence, m_communication_model.get());
+      }
+      if (m_communication_model) {
+         return m_communication_model->retime(sequence);
+      }
+      return sequence.makespan();
+   }
+
+   //! Makes all following schedules respect the given memory limits (zero
+   //! means unlimited): per thread for the tapes and the Jacobians it
+   //! produced that are still needed, and for all threads together.
+   inline auto set_memory_limits(
+        const JacobianChain& chain, const std::size_t thread_memory,
+        const std::size_t node_memory) -> void {
+      if (thread_memory == 0 && node_memory == 0) {
+         m_memory_model.reset();
+      } else if (m_memory_model.use_count() == 1) {
+         // Not shared with another scheduler, so it can be reused
+         m_memory_model->assign(chain, thread_memory, node_memory);
+      } else {
+         m_memory_model = std::make_shared<MemoryModel>(
+              chain, thread_memory, node_memory);
+      }
+   }
+
+   inline auto is_memory_aware() const -> bool {
+      return m_memory_model != nullptr;
+   }
+
+   //! Makes all following schedules pay for moving a Jacobian to another
+   //! thread (latency and cost per entry), more so across NUMA domains.
+   inline auto set_transfer_costs(
+        const JacobianChain& chain,
+        const std::pair<std::size_t, double> transfer_cost,
+        const std::pair<std::size_t, double> numa_transfer_cost,
+        const std::vector<std::size_t>& domains) -> void {
+      if (transfer_cost == std::pair<std::size_t, double>() &&
+          numa_transfer_cost == std::pair<std::size_t, double>()) {
+         m_communication_model.reset();
+      } else if (m_communication_model.use_count() == 1) {
+         // Not shared with another scheduler, so it can be reused
+         m_communication_model->assign(
+              chain, transfer_cost, numa_transfer_cost, domains);
+      } else {
+         m_communication_model = std::make_shared<CommunicationModel>(
+              chain, transfer_cost, numa_transfer_cost, domains);
+      }
+   }
+
+   inline auto is_communication_aware() const -> bool {
+      return m_communication_model != nullptr;
+   }
+
+   //! Makes the other scheduler use the same memory limits and transfer
+   //! costs.
+   inline auto share_cost_models(Scheduler& other) const -> void {
+      other.m_memory_model = m_memory_model;
+      other.m_communication_model = m_communication_model;
+   }
+
+   virtual auto schedule_impl(
+        Sequence&, const std::size_t, const std::size_t,
+        util::CancellationToken&) -> std::size_t = 0;
+
+ protected:
+   //! Earliest start of an operation on a thread, including the transfers
+   //! of its operands.
+   inline auto earliest_start(
+        const Sequence& sequence, const std::size_t op_idx,
+        const std::size_t thread) const -> std::size_t {
+      if (m_communication_model) {
+         return m_communication_model->earliest_start(
+              sequence, op_idx, thread);
+      }
+      return sequence.earliest_start(op_idx);
+   }
+
+   //! Whether schedule_impl already returns repaired schedules (see
+   //! repaired_makespan), which schedule must not repair again.
+   virtual auto is_repairing() const -> bool {
+      return false;
+   }
+
+   //! Applies the memory repair to a complete schedule and returns its
+   //! makespan afterwards. Without memory limits, the given makespan.
+   inline auto repaired_makespan(
+        Sequence& sequence, const std::size_t makespan) const -> std::size_t {
+      if (m_memory_model) {
+         return m_memory_model->repair(sequence, m_communication_model.get());
+      }
+      return makespan;
+   }
+
+   //! NUMA domain of a thread (all threads share one without transfer
+   //! costs).
+   inline auto domain(const std::size_t thread) const -> std::size_t {
+      if (m_communication_model) {
+         return m_communication_model->domain(thread);
+      }
+      return 0;
    }
 
-   virtual auto schedule_impl(Sequence&, const std::size_t, const std::size_t)
-        -> std::size_t = 0;
+ private:
+   std::shared_ptr<MemoryModel> m_memory_model;
+   std::shared_ptr<CommunicationModel> m_communication_model;
 };
 
 }  // namespace jcdp::scheduler
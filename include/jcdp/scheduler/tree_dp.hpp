@@ -0,0 +1,420 @@
+/******************************************************************************
+ * @file jcdp/scheduler/tree_dp.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides an exact
+ *        scheduler that exploits the in-tree structure of elimination
+ *        sequences: dynamic programming over the scheduled subtrees and the
+ *        availability profile of the threads.
+ ******************************************************************************/
+
+#ifndef JCDP_SCHEDULER_TREE_DP_HPP_
+#define JCDP_SCHEDULER_TREE_DP_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "jcdp/operation.hpp"
+#include "jcdp/scheduler/priority_list.hpp"
+#include "jcdp/scheduler/scheduler.hpp"
+#include "jcdp/sequence.hpp"
+#include "jcdp/util/cancellation_token.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::scheduler {
+
+/******************************************************************************
+ * @brief Finds an optimal schedule by a depth-first search over the
+ *        operations whose subtrees are complete and the threads they are
+ *        placed on. A state is the set of scheduled operations plus the
+ *        sorted thread loads and the ready times of the pending operations,
+ *        relative to the smallest load. The optimal remaining makespan of a
+ *        state is memoized, so different orders of independent subtrees that
+ *        lead to the same profile are only solved once. The memo of a call
+ *        takes at most about memo_bytes, beyond that the search continues
+ *        without memoizing (still exact, but slower). If the search is
+ *        cancelled, the best schedule found so far is used.
+ ******************************************************************************/
+class TreeDPScheduler : public Scheduler {
+ public:
+   explicit TreeDPScheduler(
+        const std::size_t memo_bytes = 64 << 20) noexcept
+        : m_memo_bytes(memo_bytes) {}
+
+   virtual auto schedule_impl(
+        Sequence& sequence, const std::size_t usable_threads,
+        const std::size_t upper_bound, util::CancellationToken& token)
+        -> std::size_t override final {
+      // The list schedule is the fallback if the search is cancelled
+      PriorityListScheduler list_scheduler;
+      share_cost_models(list_scheduler);
+      Sequence list_sequence = sequence;
+      const std::size_t list_makespan = list_scheduler.schedule_impl(
+           list_sequence, usable_threads, upper_bound, token);
+
+      // The states don't know where the operands were produced, hence
+      // transfer costs leave only the list schedule.
+      if (is_communication_aware()) {
+         if (list_makespan < upper_bound) {
+            sequence = std::move(list_sequence);
+         }
+         return list_makespan;
+      }
+
+      TreeSearch search(sequence, usable_threads, m_memo_bytes, token);
+      const std::size_t budget = std::min(list_makespan, upper_bound);
+      const std::size_t makespan = search.solve(budget);
+      if (makespan < budget) {
+         search.reconstruct(makespan);
+      }
+
+      if (search.best_makespan() < budget) {
+         search.write_best();
+         return search.best_makespan();
+      }
+      if (list_makespan < upper_bound) {
+         sequence = std::move(list_sequence);
+         return list_makespan;
+      }
+
+      // Nothing beats the upper bound, the result is a lower bound
+      return std::max(makespan, upper_bound);
+   }
+
+ private:
+   std::size_t m_memo_bytes;
+
+   //! Memoized remaining makespan of a state (relative to the smallest
+   //! load). Either exact or a lower bound if the search of the state was
+   //! cut off by its budget.
+   struct MemoEntry {
+      std::size_t makespan {0};
+      bool is_exact {false};
+   };
+
+   struct KeyHash {
+      inline auto operator()(const std::vector<std::size_t>& key) const
+           -> std::size_t {
+         std::size_t hash = key.size();
+         for (const std::size_t value : key) {
+            hash ^= std::hash<std::size_t> {}(value) + 0x9e3779b97f4a7c15 +
+                    (hash << 6) + (hash >> 2);
+         }
+         return hash;
+      }
+   };
+
+   //! State of a single call of schedule_impl, so that one scheduler may be
+   //! used by multiple tasks at once.
+   class TreeSearch {
+    public:
+      TreeSearch(
+           Sequence& sequence, const std::size_t threads,
+           const std::size_t memo_bytes, util::CancellationToken& token)
+           : m_sequence(sequence), m_token(token), m_loads(threads, 0) {
+         const std::size_t len = sequence.length();
+
+         // Key, its hash node and the entry
+         const std::size_t key_size = len / 64 + 1 + threads + len;
+         m_memo_limit = memo_bytes /
+                        (key_size * sizeof(std::size_t) + 8 * sizeof(void*));
+         m_parent.resize(len);
+         m_pending_children.assign(len, 0);
+         m_ready.assign(len, 0);
+         m_tail.assign(len, 0);
+         m_scheduled.assign(len, false);
+         m_thread.assign(len, 0);
+         m_start.assign(len, 0);
+
+         for (std::size_t op_idx = 0; op_idx < len; ++op_idx) {
+            m_parent[op_idx] = sequence.parent(op_idx);
+            if (m_parent[op_idx].has_value()) {
+               m_pending_children[m_parent[op_idx].value()]++;
+            }
+            m_remaining_fma += sequence[op_idx].fma;
+         }
+
+         // Longest path from an operation to the root. Operands are always
+         // produced before the operation that consumes them.
+         for (std::size_t op_idx = len; op_idx-- > 0;) {
+            m_tail[op_idx] = sequence[op_idx].fma;
+            if (m_parent[op_idx].has_value()) {
+               m_tail[op_idx] += m_tail[m_parent[op_idx].value()];
+            }
+         }
+      }
+
+      //! Optimal makespan if it is smaller than the budget, otherwise a
+      //! lower bound that is at least as large as the budget.
+      inline auto solve(const std::size_t budget) -> std::size_t {
+         if (!m_token.poll()) {
+            m_cancelled = true;
+            return budget;
+         }
+
+         const std::size_t min_load = std::ranges::min(m_loads);
+         const std::size_t lb = lower_bound(min_load);
+         if (unscheduled() == 0 && lb < m_best_makespan) {
+            record_best(lb);
+         }
+         if (lb >= budget || unscheduled() == 0) {
+            return lb;
+         }
+
+         std::vector<std::size_t> key = state_key(min_load);
+         if (const auto it = m_memo.find(key); it != m_memo.end()) {
+            const MemoEntry& entry = it->second;
+            if (entry.is_exact || entry.makespan + min_load >= budget) {
+               return entry.makespan + min_load;
+            }
+         }
+
+         std::size_t best = budget;
+         std::size_t bound = std::numeric_limits<std::size_t>::max();
+         for_each_move([&](const std::size_t, const std::size_t) -> bool {
+            const std::size_t makespan = solve(best);
+            bound = std::min(bound, makespan);
+            best = std::min(best, makespan);
+            return best > lb && !m_cancelled;
+         });
+
+         if (m_cancelled) {
+            return budget;
+         }
+
+         const bool is_exact = best < budget;
+         const std::size_t makespan = is_exact ? best : std::max(bound, lb);
+         if (m_memo.size() < m_memo_limit) {
+            m_memo[std::move(key)] = MemoEntry {
+                 .makespan = makespan - min_load, .is_exact = is_exact};
+         }
+         return makespan;
+      }
+
+      //! Replays the moves of a schedule with the given makespan (found by
+      //! solve, possibly via the memo) and records it as the best one.
+      inline auto reconstruct(const std::size_t makespan) -> void {
+         while (unscheduled() > 0) {
+            bool found = false;
+            for_each_move([&](const std::size_t, const std::size_t) -> bool {
+               found = solve(makespan + 1) <= makespan;
+               return !found && !m_cancelled;
+            }, true);
+
+            if (!found || m_cancelled) {
+               return;
+            }
+         }
+         record_best(makespan);
+      }
+
+      inline auto best_makespan() const -> std::size_t {
+         return m_best_makespan;
+      }
+
+      inline auto write_best() -> void {
+         for (std::size_t op_idx = 0; op_idx < m_sequence.length(); ++op_idx) {
+            m_sequence[op_idx].thread = m_best_thread[op_idx];
+            m_sequence[op_idx].start_time = m_best_start[op_idx];
+            m_sequence[op_idx].is_scheduled = true;
+         }
+      }
+
+    private:
+      Sequence& m_sequence;
+      util::CancellationToken& m_token;
+      std::size_t m_memo_limit {0};
+      bool m_cancelled {false};
+
+      // Thread loads and the in-tree
+      std::vector<std::size_t> m_loads;
+      std::vector<std::optional<std::size_t>> m_parent {};
+      std::vector<std::size_t> m_tail {};
+
+      // Per operation: unscheduled operands, end of the latest scheduled
+      // operand and the placement once it is scheduled
+      std::vector<std::size_t> m_pending_children {};
+      std::vector<std::size_t> m_ready {};
+      std::vector<bool> m_scheduled {};
+      std::vector<std::size_t> m_thread {};
+      std::vector<std::size_t> m_start {};
+      std::size_t m_remaining_fma {0};
+      std::size_t m_scheduled_ops {0};
+
+      // Ready times of the parents before the applied moves
+      std::vector<std::size_t> m_saved_ready {};
+
+      // Best complete schedule found so far
+      std::size_t m_best_makespan {std::numeric_limits<std::size_t>::max()};
+      std::vector<std::size_t> m_best_thread {};
+      std::vector<std::size_t> m_best_start {};
+
+      std::unordered_map<std::vector<std::size_t>, MemoEntry, KeyHash>
+           m_memo {};
+
+      inline auto unscheduled() const -> std::size_t {
+         return m_sequence.length() - m_scheduled_ops;
+      }
+
+      inline auto record_best(const std::size_t makespan) -> void {
+         m_best_makespan = makespan;
+         m_best_thread = m_thread;
+         m_best_start = m_start;
+      }
+
+      //! Largest load, critical path of the pending operations and average
+      //! load. Every thread is busy or idle until its load.
+      inline auto lower_bound(const std::size_t min_load) const
+           -> std::size_t {
+         const std::size_t threads = m_loads.size();
+         std::size_t lb = std::ranges::max(m_loads);
+         lb = std::max(
+              lb, (std::reduce(m_loads.cbegin(), m_loads.cend()) +
+                   m_remaining_fma + threads - 1) /
+                       threads);
+         for (std::size_t op_idx = 0; op_idx < m_sequence.length(); ++op_idx) {
+            if (!m_scheduled[op_idx]) {
+               lb = std::max(
+                    lb, std::max(m_ready[op_idx], min_load) + m_tail[op_idx]);
+            }
+         }
+         return lb;
+      }
+
+      //! Scheduled operations, sorted loads and the ready times of all
+      //! unscheduled operations with a scheduled operand. Times are relative
+      //! to the smallest load, nothing can start before it.
+      inline auto state_key(const std::size_t min_load) const
+           -> std::vector<std::size_t> {
+         std::vector<std::size_t> key;
+         key.reserve(m_loads.size() + m_sequence.length());
+
+         std::size_t word = 0;
+         for (std::size_t op_idx = 0; op_idx < m_sequence.length(); ++op_idx) {
+            if (op_idx > 0 && op_idx % 64 == 0) {
+               key.push_back(word);
+               word = 0;
+            }
+            if (m_scheduled[op_idx]) {
+               word |= std::size_t {1} << (op_idx % 64);
+            }
+         }
+         key.push_back(word);
+
+         const std::size_t loads_begin = key.size();
+         for (const std::size_t load : m_loads) {
+            key.push_back(load - min_load);
+         }
+         std::sort(key.begin() + loads_begin, key.end());
+
+         for (std::size_t op_idx = 0; op_idx < m_sequence.length(); ++op_idx) {
+            if (!m_scheduled[op_idx]) {
+               key.push_back(std::max(m_ready[op_idx], min_load) - min_load);
+            }
+         }
+         return key;
+      }
+
+      //! Applies every possible move (an operation whose operands are done
+      //! on a thread), calls visit and reverts it, until visit returns
+      //! false. Operations with the longest path to the root come first. The
+      //! operation starts as early as possible on the thread. Of the threads
+      //! that are idle before the operation is ready, only the one with the
+      //! largest load is tried (it leaves the smaller loads), and only one
+      //! thread per load. With keep = true, the move for which visit
+      //! returned false stays applied.
+      template<typename Visit>
+      inline auto for_each_move(Visit&& visit, const bool keep = false)
+           -> void {
+         const std::size_t threads = m_loads.size();
+         std::vector<std::size_t> order(threads);
+         std::iota(order.begin(), order.end(), 0);
+         std::ranges::sort(
+              order, [this](const std::size_t lhs, const std::size_t rhs)
+                          noexcept -> bool {
+                 return m_loads[lhs] < m_loads[rhs];
+              });
+
+         std::vector<std::size_t> ready_ops;
+         for (std::size_t op_idx = 0; op_idx < m_sequence.length(); ++op_idx) {
+            if (!m_scheduled[op_idx] && m_pending_children[op_idx] == 0) {
+               ready_ops.push_back(op_idx);
+            }
+         }
+         std::ranges::stable_sort(
+              ready_ops, [this](const std::size_t lhs, const std::size_t rhs)
+                              noexcept -> bool {
+                 return m_tail[lhs] > m_tail[rhs];
+              });
+
+         for (const std::size_t op_idx : ready_ops) {
+            const std::size_t ready = m_ready[op_idx];
+            for (std::size_t pos = 0; pos < threads; ++pos) {
+               const std::size_t t = order[pos];
+               if (pos + 1 < threads) {
+                  const std::size_t next_load = m_loads[order[pos + 1]];
+                  if (next_load <= ready || next_load == m_loads[t]) {
+                     continue;
+                  }
+               }
+
+               const std::size_t old_load = m_loads[t];
+               apply(op_idx, t);
+               if (!visit(op_idx, t)) {
+                  if (!keep) {
+                     revert(op_idx, t, old_load);
+                  }
+                  return;
+               }
+               revert(op_idx, t, old_load);
+            }
+         }
+      }
+
+      inline auto apply(const std::size_t op_idx, const std::size_t t)
+           -> void {
+         const std::size_t fma = m_sequence[op_idx].fma;
+         m_start[op_idx] = std::max(m_loads[t], m_ready[op_idx]);
+         m_thread[op_idx] = t;
+         m_loads[t] = m_start[op_idx] + fma;
+         m_scheduled[op_idx] = true;
+         m_scheduled_ops++;
+         m_remaining_fma -= fma;
+
+         if (m_parent[op_idx].has_value()) {
+            const std::size_t parent = m_parent[op_idx].value();
+            m_pending_children[parent]--;
+            m_saved_ready.push_back(m_ready[parent]);
+            m_ready[parent] = std::max(m_ready[parent], m_loads[t]);
+         }
+      }
+
+      inline auto revert(
+           const std::size_t op_idx, const std::size_t t,
+           const std::size_t old_load) -> void {
+         if (m_parent[op_idx].has_value()) {
+            const std::size_t parent = m_parent[op_idx].value();
+            m_pending_children[parent]++;
+            m_ready[parent] = m_saved_ready.back();
+            m_saved_ready.pop_back();
+         }
+
+         m_loads[t] = old_load;
+         m_scheduled[op_idx] = false;
+         m_scheduled_ops--;
+         m_remaining_fma += m_sequence[op_idx].fma;
+      }
+   };
+};
+
+}  // namespace jcdp::scheduler
+
+#endif  // JCDP_SCHEDULER_TREE_DP_HPP_
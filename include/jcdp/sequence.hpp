@@ -175,11 +175,25 @@ class Sequence : public std::deque<Operation> {
       return size();
    }
 
-   inline static auto make_max() -> Sequence {
-      return Sequence(Operation {
+   //! Replaces the operations by a single operation with maximal cost. The
+   //! storage of the sequence is reused.
+   inline auto assign_max() -> void {
+      clear();
+      push_back(Operation {
            .fma = std::numeric_limits<std::size_t>::max(),
            .is_scheduled = true});
    }
+
+   inline static auto make_max() -> Sequence {
+      Sequence seq {};
+      seq.assign_max();
+      return seq;
+   }
+
+   //! Whether this is the maximum sequence, which can't be evaluated.
+   inline auto is_max() const -> bool {
+      return length() == 1 && front().action == Action::NONE;
+   }
 };
 
 }  // end namespace jcdp
@@ -195,6 +209,9 @@ struct std::formatter<jcdp::Sequence> {
    auto format(const jcdp::Sequence& seq, FmtContext& ctx) const
         -> FmtContext::iterator {
       typename FmtContext::iterator out = ctx.out();
+      if (seq.is_max()) {
+         return std::format_to(out, "Maximum sequence\n");
+      }
       for (const jcdp::Operation& op : seq) {
          out = std::format_to(out, "{}\n", op);
       }
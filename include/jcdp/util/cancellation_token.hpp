@@ -0,0 +1,143 @@
+/******************************************************************************
+ * @file jcdp/util/cancellation_token.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides a token that
+ *        is polled by the solvers to stop cooperatively once a deadline or
+ *        node budget is exhausted or the solve was cancelled from outside.
+ ******************************************************************************/
+
+#ifndef JCDP_UTIL_CANCELLATION_TOKEN_HPP_
+#define JCDP_UTIL_CANCELLATION_TOKEN_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::util {
+
+/******************************************************************************
+ * @brief Thread-safe stop condition shared by all tasks of a solver.
+ *
+ * Every call to poll() counts one node. The clock is only read every
+ * CLOCK_INTERVAL polls, so polling is cheap enough to be done at every node
+ * of a search. A token may have a parent: it then stops as soon as the
+ * parent was cancelled and never runs past the deadline of the parent.
+ ******************************************************************************/
+class CancellationToken {
+ public:
+   using clock_t = std::chrono::steady_clock;
+
+   //! Number of polls between two reads of the clock (power of two).
+   static constexpr std::size_t CLOCK_INTERVAL = 64;
+
+   explicit CancellationToken(
+        const CancellationToken* parent = nullptr) noexcept
+        : m_parent(parent) {}
+
+   CancellationToken(const CancellationToken&) = delete;
+   auto operator=(const CancellationToken&) -> CancellationToken& = delete;
+
+   inline auto set_parent(const CancellationToken* parent) noexcept
+        -> void {
+      m_parent = parent;
+   }
+
+   //! (Re)starts the token. A negative time or a budget of zero means no
+   //! limit. Resets a previous cancellation of this token (not the parent).
+   //! Without inheriting the deadline of the parent, the token only stops
+   //! once the parent is cancelled explicitly (or by its own polls).
+   inline auto start(
+        const double time_to_solve = -1, const std::size_t node_budget = 0,
+        const bool inherit_deadline = true) -> void {
+      m_start = clock_t::now();
+      m_deadline = clock_t::time_point::max();
+      if (time_to_solve >= 0) {
+         m_deadline = m_start +
+                      std::chrono::duration_cast<clock_t::duration>(
+                           std::chrono::duration<double>(time_to_solve));
+      }
+      if (m_parent != nullptr && inherit_deadline) {
+         m_deadline = std::min(m_deadline, m_parent->m_deadline);
+      }
+
+      m_node_budget = node_budget;
+      m_nodes.store(0, std::memory_order_relaxed);
+      m_cancelled.store(false, std::memory_order_relaxed);
+   }
+
+   //! Cancels the token (and all tokens that have it as parent).
+   inline auto cancel() -> void {
+      m_cancelled.store(true, std::memory_order_relaxed);
+   }
+
+   //! Counts a node and returns false if the solver has to stop.
+   inline auto poll() -> bool {
+      if (is_cancelled()) {
+         return false;
+      }
+
+      const std::size_t nodes =
+           m_nodes.fetch_add(1, std::memory_order_relaxed);
+      if (m_node_budget > 0 && nodes >= m_node_budget) {
+         cancel();
+         return false;
+      }
+
+      if ((nodes & (CLOCK_INTERVAL - 1)) == 0 &&
+          m_deadline != clock_t::time_point::max() &&
+          clock_t::now() >= m_deadline) {
+         cancel();
+         return false;
+      }
+
+      return true;
+   }
+
+   //! Returns true if the token or its parent was cancelled. Doesn't read
+   //! the clock.
+   inline auto is_cancelled() const -> bool {
+      return m_cancelled.load(std::memory_order_relaxed) ||
+             (m_parent != nullptr && m_parent->is_cancelled());
+   }
+
+   //! Number of polls since the token was started.
+   inline auto nodes() const -> std::size_t {
+      return m_nodes.load(std::memory_order_relaxed);
+   }
+
+   //! Time in seconds since the token was started.
+   inline auto elapsed_time() const -> double {
+      return std::chrono::duration<double>(clock_t::now() - m_start).count();
+   }
+
+   //! Time in seconds until the deadline, -1 without deadline and 0 if the
+   //! token was cancelled.
+   inline auto remaining_time() const -> double {
+      if (is_cancelled()) {
+         return 0;
+      }
+      if (m_deadline == clock_t::time_point::max()) {
+         return -1;
+      }
+      return std::max(
+           std::chrono::duration<double>(m_deadline - clock_t::now()).count(),
+           0.0);
+   }
+
+ private:
+   const CancellationToken* m_parent {nullptr};
+   clock_t::time_point m_start {clock_t::now()};
+   clock_t::time_point m_deadline {clock_t::time_point::max()};
+   std::size_t m_node_budget {0};
+   std::atomic<std::size_t> m_nodes {0};
+   std::atomic<bool> m_cancelled {false};
+};
+
+}  // end namespace jcdp::util
+
+#endif  // JCDP_UTIL_CANCELLATION_TOKEN_HPP_
@@ -0,0 +1,203 @@
+/******************************************************************************
+ * @file jcdp/util/cpp_writer.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides a code generator
+ *        that converts elimination sequences into C++ translation units which
+ *        evaluate the chain as an OpenMP task graph.
+ ******************************************************************************/
+
+#ifndef JCDP_UTIL_CPP_WRITER_HPP_
+#define JCDP_UTIL_CPP_WRITER_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <print>
+#include <string>
+#include <vector>
+
+#include "jcdp/jacobian.hpp"
+#include "jcdp/jacobian_chain.hpp"
+#include "jcdp/operation.hpp"
+#include "jcdp/sequence.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::util {
+
+//! Writes sequence_<name>.cpp with the function jcdp_<name>::evaluate that
+//! stores the Jacobian of the whole chain in a user-provided buffer. The
+//! code is specialized to the sizes of the chain: every intermediate
+//! Jacobian is a static, dense, row-major array, hence evaluate is not
+//! reentrant. The operations are OpenMP tasks in the order of their start
+//! times, with depend clauses on their operands, which call the following
+//! hooks the user has to define in the same namespace:
+//!
+//! tangent(j, i, columns, in, out): Evaluates elementals i, ..., j in tangent
+//!    mode for each column of in (n_i x columns), or of the identity if in
+//!    is nullptr, and stores the results in out (m_j x columns).
+//! adjoint(j, i, rows, in, out): Evaluates elementals i, ..., j in adjoint
+//!    mode for each row of in (rows x m_j), or of the identity if in is
+//!    nullptr, and stores the results in out (rows x n_i).
+//! gemm(m, l, n, lhs, rhs, out): out (m x n) = lhs (m x l) * rhs (l x n).
+//!
+//! Nothing is written for the maximum sequence or for operations with an
+//! unknown action or mode.
+inline auto write_cpp(
+     const JacobianChain& chain, const Sequence& sequence,
+     const std::string& name) -> void {
+   const bool is_evaluable = std::ranges::all_of(
+        sequence, [](const Operation& op) noexcept -> bool {
+           switch (op.action) {
+              case Action::MULTIPLICATION: {
+                 return true;
+              }
+
+              case Action::ACCUMULATION:
+              case Action::ELIMINATION: {
+                 return op.mode == Mode::TANGENT || op.mode == Mode::ADJOINT;
+              }
+
+              default: {
+                 return false;
+              }
+           }
+        });
+   if (sequence.empty() || !is_evaluable) {
+      std::println(
+           std::cerr, "No code for sequence {}, it can't be evaluated", name);
+      return;
+   }
+
+   std::filesystem::path output_file = "sequence_" + name + ".cpp";
+   std::ofstream out(output_file);
+   if (!out) {
+      std::println(std::cerr, "Failed to open {}", output_file.string());
+      return;
+   }
+
+   // Start time order, operands first on ties (e.g. unscheduled sequences)
+   std::vector<std::size_t> order(sequence.length());
+   std::iota(order.begin(), order.end(), 0);
+   std::ranges::stable_sort(
+        order, [&sequence](const std::size_t lhs, const std::size_t rhs) {
+           const Operation& l_op = sequence[lhs];
+           const Operation& r_op = sequence[rhs];
+           if (l_op.start_time == r_op.start_time) {
+              return sequence.level(lhs) > sequence.level(rhs);
+           }
+           return l_op.start_time < r_op.start_time;
+        });
+
+   std::size_t threads = 1;
+   for (const Operation& op : sequence) {
+      threads = std::max(threads, op.thread + 1);
+   }
+
+   const std::size_t length = chain.length();
+   const Jacobian& result = chain.get_jacobian(length - 1, 0);
+   auto buffer = [length](const std::size_t j, const std::size_t i) {
+      if (j == length - 1 && i == 0) {
+         return std::string("jacobian");
+      }
+      return std::format("jac_{}_{}", j, i);
+   };
+
+   std::println(out, "// Generated by JCDP, do not edit.\n");
+   std::println(out, "#include <cstddef>\n");
+   std::println(out, "namespace jcdp_{} {{\n", name);
+   std::println(out, "inline constexpr std::size_t m = {};", result.m);
+   std::println(out, "inline constexpr std::size_t n = {};\n", result.n);
+
+   std::println(
+        out,
+        "void tangent(std::size_t j, std::size_t i, std::size_t columns, "
+        "const double* in,\n             double* out);");
+   std::println(
+        out,
+        "void adjoint(std::size_t j, std::size_t i, std::size_t rows, "
+        "const double* in,\n             double* out);");
+   std::println(
+        out,
+        "void gemm(std::size_t m, std::size_t l, std::size_t n, "
+        "const double* lhs,\n          const double* rhs, double* out);\n");
+
+   std::println(out, "namespace {{\n");
+   for (const std::size_t op_idx : order) {
+      const Operation& op = sequence[op_idx];
+      if (buffer(op.j, op.i) != "jacobian") {
+         const Jacobian& jac = chain.get_jacobian(op.j, op.i);
+         std::println(
+              out, "alignas(64) double {}[{}];", buffer(op.j, op.i),
+              std::max(jac.m * jac.n, std::size_t {1}));
+      }
+   }
+   std::println(out, "\n}}  // namespace\n");
+
+   std::println(out, "//! Stores the Jacobian (m x n) of the chain.");
+   std::println(out, "void evaluate(double* jacobian) {{");
+   std::println(out, "#pragma omp parallel num_threads({})", threads);
+   std::println(out, "#pragma omp single");
+   std::println(out, "   {{");
+   for (const std::size_t op_idx : order) {
+      const Operation& op = sequence[op_idx];
+      const std::string output = buffer(op.j, op.i);
+      std::println(out, "      // {}", op);
+
+      if (op.action == Action::ACCUMULATION) {
+         std::println(out, "#pragma omp task depend(out: {})", output);
+         std::println(
+              out, "      {}({}, {}, {}, nullptr, {});",
+              (op.mode == Mode::TANGENT) ? "tangent" : "adjoint", op.j, op.i,
+              (op.mode == Mode::TANGENT)
+                   ? chain.get_jacobian(op.i, op.i).n
+                   : chain.get_jacobian(op.j, op.j).m,
+              output);
+         continue;
+      }
+
+      const Jacobian& jk_jac = chain.get_jacobian(op.j, op.k + 1);
+      const Jacobian& ki_jac = chain.get_jacobian(op.k, op.i);
+      const std::string jk = buffer(op.j, op.k + 1);
+      const std::string ki = buffer(op.k, op.i);
+      if (op.action == Action::MULTIPLICATION) {
+         std::println(
+              out, "#pragma omp task depend(in: {}, {}) depend(out: {})", jk,
+              ki, output);
+         std::println(
+              out, "      gemm({}, {}, {}, {}, {}, {});", jk_jac.m, ki_jac.m,
+              ki_jac.n, jk, ki, output);
+      } else if (op.mode == Mode::TANGENT) {
+         std::println(
+              out, "#pragma omp task depend(in: {}) depend(out: {})", ki,
+              output);
+         std::println(
+              out, "      tangent({}, {}, {}, {}, {});", op.j, op.k + 1,
+              ki_jac.n, ki, output);
+      } else {
+         std::println(
+              out, "#pragma omp task depend(in: {}) depend(out: {})", jk,
+              output);
+         std::println(
+              out, "      adjoint({}, {}, {}, {}, {});", op.k, op.i, jk_jac.m,
+              jk, output);
+      }
+   }
+   std::println(out, "   }}");
+   std::println(out, "}}\n");
+   std::println(out, "}}  // namespace jcdp_{}", name);
+
+   out.close();
+}
+
+}  // end namespace jcdp::util
+
+// >>>>>>>>>>>>>>>> INCLUDE TEMPLATE AND INLINE DEFINITIONS <<<<<<<<<<<<<<<<< //
+
+#endif  // JCDP_UTIL_CPP_WRITER_HPP_
@@ -24,6 +24,10 @@ namespace jcdp::util {
 
 inline auto write_dot(const Sequence& sequence, const std::string& name)
      -> void {
+   if (sequence.is_max()) {
+      std::println(std::cerr, "No graph for the maximum sequence {}", name);
+      return;
+   }
 
    std::filesystem::path output_file = "sequence_" + name + ".dot";
    std::ofstream out(output_file);
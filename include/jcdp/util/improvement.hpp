@@ -0,0 +1,67 @@
+/******************************************************************************
+ * @file jcdp/util/improvement.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides a base class
+ *        for solvers that report every improvement of their incumbent to a
+ *        user-defined callback, e.g. to record time-to-quality traces.
+ ******************************************************************************/
+
+#ifndef JCDP_UTIL_IMPROVEMENT_HPP_
+#define JCDP_UTIL_IMPROVEMENT_HPP_
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::util {
+
+/******************************************************************************
+ * @brief State of a solver right after its incumbent improved.
+ ******************************************************************************/
+struct Improvement {
+   //! Makespan of the new incumbent.
+   std::size_t makespan {0};
+
+   //! Best known lower bound for the makespan at that time.
+   std::size_t lower_bound {0};
+
+   //! Amount of threads the incumbent was found for (0 = unlimited).
+   std::size_t threads {0};
+
+   //! Time in seconds since the solver was started.
+   double elapsed_time {0};
+};
+
+/******************************************************************************
+ * @brief Holds an optional callback that is invoked on every improvement of
+ *        the incumbent.
+ ******************************************************************************/
+class ImprovementNotifier {
+ public:
+   using Callback = std::function<void(const Improvement&)>;
+
+   //! Sets the callback. The callback may be invoked from multiple threads
+   //! and should be cheap since it blocks the reporting solver.
+   inline auto on_improvement(Callback callback) -> void {
+      m_on_improvement = std::move(callback);
+   }
+
+ protected:
+   inline auto notify_improvement(const Improvement& improvement) const
+        -> void {
+      if (m_on_improvement) {
+         m_on_improvement(improvement);
+      }
+   }
+
+ private:
+   Callback m_on_improvement {};
+};
+
+}  // end namespace jcdp::util
+
+#endif  // JCDP_UTIL_IMPROVEMENT_HPP_
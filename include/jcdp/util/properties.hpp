@@ -137,6 +137,18 @@ class PropertyInfo<std::pair<T1, T2>>
    virtual auto to_string() const -> const std::string override final;
 };
 
+template<>
+class PropertyInfo<std::string> : public PropertyInfoBase<std::string> {
+ public:
+   using PropertyInfoBase<std::string>::PropertyInfoBase;
+
+   //! Implements pipe function by deferencing stored pointer _ptr.
+   virtual auto from_pipe(std::istream& i) -> void override final;
+
+   //! Return the value as a string.
+   virtual auto to_string() const -> const std::string override final;
+};
+
 template<typename T>
 class PropertyInfo<std::vector<T>> : public PropertyInfoBase<std::vector<T>> {
  public:
@@ -185,6 +197,11 @@ class Properties {
         const std::filesystem::path& config_filename,
         bool skip_not_registered_keys = false) -> void;
 
+   //! Parses a config from an arbitrary stream, e.g. a config that was
+   //! read into memory once and is applied to multiple Properties.
+   auto parse_config(std::istream& in, bool skip_not_registered_keys = false)
+        -> void;
+
    //! Prints the keys and descriptions of all registeres properties in a
    //! structured way.
    auto print_help(std::ostream& o) -> void;
@@ -197,7 +214,7 @@ class Properties {
    //! Finds the property which is registered under key and pipes value
    //! into it. Also executes the associated _on_read.
    auto put(
-        const std::string& key, std::ifstream& in,
+        const std::string& key, std::istream& in,
         bool skip_not_registered_keys) -> void;
 
    //! Find the maximum key length of all registered properties.
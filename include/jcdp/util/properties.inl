@@ -113,6 +113,10 @@ inline auto PropertyInfo<std::pair<T1, T2>>::from_pipe(std::istream& i)
    i >> this->m_ptr->first >> this->m_ptr->second;
 }
 
+inline auto PropertyInfo<std::string>::from_pipe(std::istream& i) -> void {
+   i >> *(this->m_ptr);
+}
+
 template<typename T>
 inline auto PropertyInfo<std::vector<T>>::from_pipe(std::istream& i) -> void {
    this->m_ptr->clear();
@@ -141,6 +145,10 @@ inline auto PropertyInfo<std::pair<T1, T2>>::to_string() const
           std::to_string(this->m_ptr->second);
 }
 
+inline auto PropertyInfo<std::string>::to_string() const -> const std::string {
+   return *(this->m_ptr);
+}
+
 template<typename T>
 inline auto PropertyInfo<std::vector<T>>::to_string() const
      -> const std::string {
@@ -205,7 +213,7 @@ inline Properties::~Properties() {
  * @param[in] skip_not_registered_keys Ignore when we encounter an unknown key.
  ******************************************************************************/
 inline auto Properties::put(
-     const std::string& key, std::ifstream& in,
+     const std::string& key, std::istream& in,
      const bool skip_not_registered_keys) -> void {
 
    for (auto& pi : m_info) {
@@ -237,6 +245,17 @@ inline auto Properties::parse_config(
       throw BadConfigFileError();
    }
 
+   parse_config(in, skip_not_registered_keys);
+}
+
+/******************************************************************************
+ * @brief Parses a config from a std::istream.
+ *
+ * @param[in] in Stream from which to read the properties.
+ * @param[in] skip_not_registered_keys Ignore when we encounter an unknown key.
+ ******************************************************************************/
+inline auto Properties::parse_config(
+     std::istream& in, const bool skip_not_registered_keys) -> void {
    std::string key;
    while (in >> key) {
       put(key, in, skip_not_registered_keys);
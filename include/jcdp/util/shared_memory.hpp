@@ -0,0 +1,70 @@
+/******************************************************************************
+ * @file jcdp/util/shared_memory.hpp
+ *
+ * @brief This file is part of the JCDP package. It provides an anonymous
+ *        memory mapping that is shared with child processes created via
+ *        fork(). Only available on Linux.
+ ******************************************************************************/
+
+#ifndef JCDP_UTIL_SHARED_MEMORY_HPP_
+#define JCDP_UTIL_SHARED_MEMORY_HPP_
+
+#if defined(__linux__)
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <sys/mman.h>
+
+#include <cstddef>
+#include <stdexcept>
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace jcdp::util {
+
+/******************************************************************************
+ * @brief Zero-initialized memory that stays shared between the process and
+ *        all children forked after its creation.
+ ******************************************************************************/
+class SharedMemory {
+ public:
+   explicit SharedMemory(const std::size_t size) : m_size(size) {
+      m_data = mmap(
+           nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+           -1, 0);
+      if (m_data == MAP_FAILED) {
+         throw std::runtime_error("Failed to map shared memory.");
+      }
+   }
+
+   SharedMemory(const SharedMemory&) = delete;
+   auto operator=(const SharedMemory&) -> SharedMemory& = delete;
+
+   ~SharedMemory() {
+      munmap(m_data, m_size);
+   }
+
+   //! Pointer to the object of type T at the given byte offset. The object
+   //! has to be created via placement new before it is used.
+   template<typename T>
+   inline auto at(const std::size_t offset) const -> T* {
+      return static_cast<T*>(static_cast<void*>(
+           static_cast<std::byte*>(m_data) + offset));
+   }
+
+   //! Rounds a size up so that any object may be placed behind it.
+   inline static auto align(const std::size_t size) -> std::size_t {
+      constexpr std::size_t alignment = alignof(std::max_align_t);
+      return (size + alignment - 1) / alignment * alignment;
+   }
+
+ private:
+   std::size_t m_size;
+   void* m_data;
+};
+
+}  // end namespace jcdp::util
+
+#endif  // __linux__
+
+#endif  // JCDP_UTIL_SHARED_MEMORY_HPP_
@@ -10,22 +10,25 @@
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
-#include <chrono>
-#include <print>
+#include <cstddef>
+
+#include "jcdp/util/cancellation_token.hpp"
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>> HEADER CONTENTS <<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
 namespace jcdp::util {
 
 /******************************************************************************
- * @brief Simple timer to limit the time the branch & bound solvers run.
+ * @brief Simple timer to limit the time and the amount of nodes the branch &
+ *        bound solvers use. Backed by a CancellationToken that is polled at
+ *        every node and may be cancelled from outside.
  ******************************************************************************/
 class Timer {
  protected:
-   using timer_t = std::chrono::steady_clock;
-   timer_t::time_point m_start = timer_t::now();
    double m_time_to_solve {-1};
+   std::size_t m_node_budget {0};
    bool m_timer_expired {false};
+   CancellationToken m_token {};
 
  public:
    inline auto set_timer(const double time_to_solve) {
@@ -33,26 +36,46 @@ class Timer {
       m_timer_expired = false;
    }
 
+   //! Sets the maximal amount of nodes (0 = unlimited).
+   inline auto set_node_budget(const std::size_t node_budget) {
+      m_node_budget = node_budget;
+   }
+
+   //! Links the timer to an external token, e.g. to cancel several solvers
+   //! at once. The token has to outlive the solve.
+   inline auto set_parent_token(const CancellationToken* parent) -> void {
+      m_token.set_parent(parent);
+   }
+
    inline auto start_timer() -> void {
-      m_start = timer_t::now();
+      m_token.start(m_time_to_solve, m_node_budget);
    }
 
-   inline auto remaining_time() -> double {
-      double rem = -1;
-      if (m_time_to_solve >= 0) {
-         auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
-              timer_t::now() - m_start);
+   //! Stops the running solve as soon as possible. Thread-safe.
+   inline auto cancel() -> void {
+      m_token.cancel();
+   }
 
-         rem = m_time_to_solve;
-         rem -= std::min(elapsed.count() / 1'000'000.0, rem);
-      }
+   //! Time in seconds since the timer was started.
+   inline auto elapsed_time() const -> double {
+      return m_token.elapsed_time();
+   }
 
+   //! Time in seconds until the deadline (-1 = unlimited). Reads the clock,
+   //! use poll() at the nodes of a search instead.
+   inline auto remaining_time() -> double {
+      const double rem = m_token.remaining_time();
       m_timer_expired |= !rem;
       return rem;
    }
 
+   //! Counts a node and returns false if the solver has to stop.
+   inline auto poll() -> bool {
+      return m_token.poll();
+   }
+
    inline auto finished_in_time() const -> bool {
-      return !m_timer_expired;
+      return !m_timer_expired && !m_token.is_cancelled();
    }
 };
 
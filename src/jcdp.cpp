@@ -2,9 +2,12 @@
  * @file jcdp.cpp
  *
  * @brief This file is part of the JCDP package. It provides an applications
- *        that generated Jacobian chains based on a given config file and runs
- *        dynamic programming, and Branch & Bound optimizers combined with
- *        a list scheduler and a Branch & Bound scheduler.
+ *        that generated Jacobian chains based on a given config file (or
+ *        reads them from a chain file) and runs dynamic programming, and
+ *        Branch & Bound optimizers combined with a list scheduler and a
+ *        Branch & Bound scheduler (plus an exact tree DP scheduler for the
+ *        DP solution). A local search, a beam search and a portfolio that
+ *        runs all strategies concurrently can be enabled in the config file.
  ******************************************************************************/
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
@@ -13,32 +16,76 @@
 #include <filesystem>
 #include <iostream>
 #include <memory>
+#include <optional>
 
+#include "jcdp/chain_file.hpp"
 #include "jcdp/generator.hpp"
 #include "jcdp/jacobian_chain.hpp"
 #include "jcdp/operation.hpp"
+#include "jcdp/optimizer/beam_search.hpp"
 #include "jcdp/optimizer/branch_and_bound.hpp"
 #include "jcdp/optimizer/dynamic_programming.hpp"
+#include "jcdp/optimizer/local_search.hpp"
+#include "jcdp/optimizer/portfolio.hpp"
 #include "jcdp/scheduler/branch_and_bound.hpp"
 #include "jcdp/scheduler/priority_list.hpp"
+#include "jcdp/scheduler/tree_dp.hpp"
 #include "jcdp/sequence.hpp"
+#include "jcdp/util/cpp_writer.hpp"
 #include "jcdp/util/dot_writer.hpp"
+#include "jcdp/util/properties.hpp"
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> APPLICATION <<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
+namespace {
+
+/******************************************************************************
+ * @brief Selection of the solvers that run in addition to the DP and the
+ *        Branch & Bound solvers.
+ ******************************************************************************/
+class SolverProperties : public jcdp::util::Properties {
+ public:
+   SolverProperties() {
+      register_property(
+           m_local_search, "local_search",
+           "Whether the DP solution is improved via local search.");
+      register_property(
+           m_beam_search, "beam_search",
+           "Whether the chain is solved via beam search + list scheduling.");
+      register_property(
+           m_portfolio, "portfolio",
+           "Whether all strategies are run once more concurrently as a "
+           "portfolio.");
+   }
+
+   bool m_local_search {false};
+   bool m_beam_search {false};
+   bool m_portfolio {false};
+};
+
+}  // namespace
+
 int main(int argc, char* argv[]) {
    jcdp::JacobianChainGenerator jcgen;
+   jcdp::ChainFileProperties chain_file_props;
+   SolverProperties solver_props;
    jcdp::optimizer::DynamicProgrammingOptimizer dp_solver;
    jcdp::optimizer::BranchAndBoundOptimizer bnb_solver;
+   jcdp::optimizer::LocalSearchOptimizer ls_solver;
+   jcdp::optimizer::BeamSearchOptimizer beam_solver;
+   jcdp::optimizer::PortfolioOptimizer portfolio;
 
    std::shared_ptr<jcdp::scheduler::BranchAndBoundScheduler> bnb_scheduler =
         std::make_shared<jcdp::scheduler::BranchAndBoundScheduler>();
    std::shared_ptr<jcdp::scheduler::PriorityListScheduler> list_scheduler =
         std::make_shared<jcdp::scheduler::PriorityListScheduler>();
+   std::shared_ptr<jcdp::scheduler::TreeDPScheduler> tree_scheduler =
+        std::make_shared<jcdp::scheduler::TreeDPScheduler>();
 
    if (argc < 2) {
       jcgen.print_help(std::cout);
       dp_solver.print_help(std::cout);
+      solver_props.print_help(std::cout);
       return -1;
    }
 
@@ -46,8 +93,13 @@ int main(int argc, char* argv[]) {
    try {
       dp_solver.parse_config(config_filename, true);
       bnb_solver.parse_config(config_filename, true);
+      ls_solver.parse_config(config_filename, true);
+      beam_solver.parse_config(config_filename, true);
+      portfolio.parse_configs(config_filename);
       jcgen.parse_config(config_filename, true);
       jcgen.init_rng();
+      chain_file_props.parse_config(config_filename, true);
+      solver_props.parse_config(config_filename, true);
    } catch (const std::runtime_error& bcfe) {
       std::println(std::cerr, "{}", bcfe.what());
       return -1;
@@ -60,9 +112,29 @@ int main(int argc, char* argv[]) {
    dp_solver.print_values(std::cout);
 
    jcdp::JacobianChain chain;
-   jcgen.next(chain);
+   try {
+      if (chain_file_props.m_chain_file.empty()) {
+         jcgen.next(chain);
+      } else if (!jcdp::ChainFileReader(chain_file_props.m_chain_file)
+                       .next(chain)) {
+         std::println(
+              std::cerr, "No chain in {}", chain_file_props.m_chain_file);
+         return -1;
+      }
+
+      if (!chain_file_props.m_save_chains.empty()) {
+         jcdp::ChainFileWriter(chain_file_props.m_save_chains).write(chain);
+      }
+   } catch (const jcdp::BadChainError& bce) {
+      std::println(std::cerr, "{}", bce.what());
+      return -1;
+   }
+   const std::optional<double> seconds_per_fma = dp_solver.calibrate(chain);
    chain.init_subchains();
 
+   if (seconds_per_fma.has_value()) {
+      std::println("\nCalibrated costs, seconds per fma: {}", *seconds_per_fma);
+   }
    std::println(
         "\nTangent cost: {}",
         chain.get_jacobian(chain.length() - 1, 0).fma<jcdp::Mode::TANGENT>());
@@ -72,6 +144,9 @@ int main(int argc, char* argv[]) {
 
    // Solve via dynamic programming
    dp_solver.init(chain);
+   dp_solver.configure_scheduler(*bnb_scheduler);
+   dp_solver.configure_scheduler(*list_scheduler);
+   dp_solver.configure_scheduler(*tree_scheduler);
    auto start_dp = std::chrono::high_resolution_clock::now();
    jcdp::Sequence dp_seq = dp_solver.solve();
    auto end_dp = std::chrono::high_resolution_clock::now();
@@ -81,6 +156,7 @@ int main(int argc, char* argv[]) {
    std::println("{}", dp_seq);
 
    jcdp::util::write_dot(dp_seq, "dynamic_programming");
+   jcdp::util::write_cpp(chain, dp_seq, "dynamic_programming");
 
    // Schedule dynamic programming sequence via list scheduling
    auto start_list_sched = std::chrono::high_resolution_clock::now();
@@ -104,9 +180,23 @@ int main(int argc, char* argv[]) {
         "Optimized cost (DP + B&B scheduling): {}\n", dp_seq.makespan());
    std::println("{}", dp_seq);
 
-   // Solve via branch & bound + List scheduling
+   // Schedule dynamic programming sequence via the exact tree DP
+   jcdp::Sequence tree_seq = dp_seq;
+   auto start_tree_sched = std::chrono::high_resolution_clock::now();
+   tree_scheduler->schedule(tree_seq, dp_solver.m_usable_threads);
+   auto end_tree_sched = std::chrono::high_resolution_clock::now();
+   std::chrono::duration<double> duration_tree_sched = end_tree_sched -
+                                                       start_tree_sched;
+   std::println(
+        "\nScheduling duration: {} seconds", duration_tree_sched.count());
+   std::println(
+        "Optimized cost (DP + Tree DP scheduling): {}\n", tree_seq.makespan());
+   std::println("{}", tree_seq);
+
+   // Solve via branch & bound + List scheduling (guided by the DP solution)
    bnb_solver.init(chain, list_scheduler);
    bnb_solver.set_upper_bound(dp_seq.makespan());
+   bnb_solver.set_guide(dp_seq);
    auto start_bnb_list = std::chrono::high_resolution_clock::now();
    jcdp::Sequence bnb_seq_list = bnb_solver.solve();
    auto end_bnb_list = std::chrono::high_resolution_clock::now();
@@ -120,9 +210,10 @@ int main(int argc, char* argv[]) {
         bnb_seq_list.makespan());
    std::println("{}", bnb_seq_list);
 
-   // Solve via branch & bound
+   // Solve via branch & bound, warm-started with the list scheduling result
    bnb_solver.init(chain, bnb_scheduler);
-   bnb_solver.set_upper_bound(bnb_seq_list.makespan());
+   bnb_solver.set_incumbent(bnb_seq_list);
+   bnb_solver.set_guide(dp_seq);
    auto start_bnb = std::chrono::high_resolution_clock::now();
    jcdp::Sequence bnb_seq = bnb_solver.solve();
    auto end_bnb = std::chrono::high_resolution_clock::now();
@@ -132,7 +223,61 @@ int main(int argc, char* argv[]) {
    std::println("Optimized cost (BnB): {}\n", bnb_seq.makespan());
    std::println("{}", bnb_seq);
 
-   jcdp::util::write_dot(bnb_seq, "branch_and_bound");
+   // Nothing to write if no sequence fits into memory
+   if (!bnb_seq.is_max()) {
+      jcdp::util::write_dot(bnb_seq, "branch_and_bound");
+      jcdp::util::write_cpp(chain, bnb_seq, "branch_and_bound");
+   }
+
+   // Improve the DP solution via local search
+   if (solver_props.m_local_search) {
+      ls_solver.init(chain);
+      ls_solver.set_incumbent(dp_seq);
+      auto start_ls = std::chrono::high_resolution_clock::now();
+      jcdp::Sequence ls_seq = ls_solver.solve();
+      list_scheduler->retime(ls_seq);
+      auto end_ls = std::chrono::high_resolution_clock::now();
+      std::chrono::duration<double> duration_ls = end_ls - start_ls;
+      std::println(
+           "\nLocal search solve duration: {} seconds", duration_ls.count());
+      ls_solver.print_stats();
+      std::println("Optimized cost (Local search): {}\n", ls_seq.makespan());
+      std::println("{}", ls_seq);
+   }
+
+   // Solve via beam search + List scheduling (never worse than DP)
+   if (solver_props.m_beam_search) {
+      beam_solver.init(chain, list_scheduler);
+      beam_solver.set_incumbent(dp_seq);
+      auto start_beam = std::chrono::high_resolution_clock::now();
+      jcdp::Sequence beam_seq = beam_solver.solve();
+      auto end_beam = std::chrono::high_resolution_clock::now();
+      std::chrono::duration<double> duration_beam = end_beam - start_beam;
+      std::println(
+           "\nBeam search solve duration: {} seconds", duration_beam.count());
+      beam_solver.print_stats();
+      std::println(
+           "Optimized cost (Beam search + List scheduling): {}\n",
+           beam_seq.makespan());
+      std::println("{}", beam_seq);
+   }
+
+   // Run all strategies at once on partitioned cores
+   if (solver_props.m_portfolio) {
+      portfolio.init(chain);
+      auto start_portfolio = std::chrono::high_resolution_clock::now();
+      jcdp::Sequence portfolio_seq = portfolio.solve();
+      auto end_portfolio = std::chrono::high_resolution_clock::now();
+      std::chrono::duration<double> duration_portfolio = end_portfolio -
+                                                         start_portfolio;
+      std::println(
+           "\nPortfolio solve duration: {} seconds",
+           duration_portfolio.count());
+      portfolio.print_stats();
+      std::println(
+           "Optimized cost (Portfolio): {}\n", portfolio_seq.makespan());
+      std::println("{}", portfolio_seq);
+   }
 
    return 0;
 }
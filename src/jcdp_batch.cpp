@@ -6,21 +6,34 @@
  *        them. The makespan of the calculated sequences are stored in CSV
  *        files. The generator and solver properties can be provided via a
  *        config files that is expected as the first command line argument.
+ *        If a third argument is given, the improvements of the branch & bound
+ *        optimizers are written to CSV files with that prefix. Instead of
+ *        generating the chains, they can be read from a chain file.
  ******************************************************************************/
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
+#include <algorithm>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <map>
 #include <memory>
+#include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "jcdp/chain_file.hpp"
 #include "jcdp/generator.hpp"
 #include "jcdp/jacobian_chain.hpp"
 #include "jcdp/optimizer/branch_and_bound.hpp"
 #include "jcdp/optimizer/dynamic_programming.hpp"
 #include "jcdp/scheduler/branch_and_bound.hpp"
 #include "jcdp/scheduler/priority_list.hpp"
+#include "jcdp/sequence.hpp"
+#include "jcdp/util/improvement.hpp"
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> APPLICATION <<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
 
@@ -56,16 +69,40 @@ int main(int argc, char* argv[]) {
       output_file_name = argv[2];
    }
 
-   jcdp::JacobianChain chain;
-   while (!jcgen.empty()) {
-      const std::size_t len = jcgen.current_length();
-      std::filesystem::path output_file =
-           (output_file_name + std::to_string(len) + ".csv");
+   jcdp::ChainFileProperties chain_file_props;
+   try {
+      chain_file_props.parse_config(config_filename, true);
+   } catch (const std::runtime_error& bcfe) {
+      std::println(std::cerr, "{}", bcfe.what());
+      return -1;
+   }
+
+   // Result and trace files per chain length, opened on first use.
+   std::map<std::size_t, std::ofstream> outs;
+   std::map<std::size_t, std::ofstream> trace_outs;
+   auto open_output = [&](const std::size_t len) -> std::ofstream* {
+      if (auto it = outs.find(len); it != outs.end()) {
+         return &it->second;
+      }
 
+      const std::filesystem::path output_file =
+           (output_file_name + std::to_string(len) + ".csv");
       std::ofstream out(output_file);
       if (!out) {
          std::println(std::cerr, "Failed to open {}", output_file.string());
-         return -1;
+         return nullptr;
+      }
+
+      if (argc > 3) {
+         const std::filesystem::path trace_file =
+              (std::string(argv[3]) + std::to_string(len) + ".csv");
+         std::ofstream trace_out(trace_file);
+         if (!trace_out) {
+            std::println(std::cerr, "Failed to open {}", trace_file.string());
+            return nullptr;
+         }
+         std::println(trace_out, "chain,solver,threads,time,makespan,lb");
+         trace_outs[len] = std::move(trace_out);
       }
 
       for (std::size_t t = 1; t <= len; ++t) {
@@ -76,44 +113,148 @@ int main(int argc, char* argv[]) {
          std::print(out, "DP_BnB/{}{}", t, (t < len) ? "," : "\n");
       }
 
-      while (jcgen.next(chain)) {
-         chain.init_subchains();
+      return &(outs[len] = std::move(out));
+   };
+
+   // Time-to-quality traces of the branch & bound optimizers. The callback is
+   // invoked from within a critical section, so no further locking needed.
+   std::ofstream* trace_out = nullptr;
+   std::string trace_solver;
+   std::size_t trace_chain_id = 0;
+   if (argc > 3) {
+      bnb_solver.on_improvement([&](const jcdp::util::Improvement& imp) {
+         std::println(
+              *trace_out, "{},{},{},{},{},{}", trace_chain_id, trace_solver,
+              imp.threads, imp.elapsed_time, imp.makespan, imp.lower_bound);
+      });
+   }
 
-         // Solve via dynamic programming
-         dp_solver.init(chain);
-         dp_solver.m_usable_threads = len;
-         dp_solver.solve();
+   std::optional<jcdp::ChainFileWriter> chain_writer;
+   try {
+      if (!chain_file_props.m_save_chains.empty()) {
+         chain_writer.emplace(chain_file_props.m_save_chains);
+      }
+   } catch (const jcdp::BadChainError& bce) {
+      std::println(std::cerr, "{}", bce.what());
+      return -1;
+   }
+
+   auto solve = [&](jcdp::JacobianChain& chain) -> bool {
+      const std::size_t len = chain.length();
+      std::ofstream* out = open_output(len);
+      if (out == nullptr) {
+         return false;
+      }
+      if (argc > 3) {
+         trace_out = &trace_outs[len];
+      }
+      if (chain_writer) {
+         chain_writer->write(chain);
+      }
 
+      dp_solver.calibrate(chain);
+      chain.init_subchains();
+
+      // Solve via dynamic programming
+      dp_solver.init(chain);
+      dp_solver.configure_scheduler(*bnb_scheduler);
+      dp_solver.configure_scheduler(*list_scheduler);
+      dp_solver.m_usable_threads = len;
+      dp_solver.solve();
+
+      // Schedule dynamic programming sequences via branch & bound
+      std::vector<jcdp::Sequence> dp_seqs(len);
+      std::vector<std::size_t> dp_makespans(len);
+      for (std::size_t t = 1; t <= len; ++t) {
+         dp_seqs[t - 1] = dp_solver.get_sequence(t);
+         dp_makespans[t - 1] = dp_seqs[t - 1].makespan();
+
+         // The DP schedule ignores memory, but its makespan is still a
+         // valid lower bound.
+         std::size_t upper_bound = dp_makespans[t - 1];
+         if (list_scheduler->is_memory_aware()) {
+            upper_bound = list_scheduler->schedule(dp_seqs[t - 1], t);
+            if (upper_bound == std::numeric_limits<std::size_t>::max()) {
+               continue;
+            }
+         }
+         bnb_scheduler->schedule(dp_seqs[t - 1], t, upper_bound);
+      }
+
+      // The DP makespans for unlimited threads and for a single thread
+      // bound the critical path and the total fma of every sequence.
+      auto set_lower_bounds = [&]() -> void {
          for (std::size_t t = 1; t <= len; ++t) {
-            jcdp::Sequence dp_seq = dp_solver.get_sequence(t);
-            const std::size_t dp_makespan = dp_seq.makespan();
-
-            // Schedule dynamic programming sequence via branch & bound
-            bnb_scheduler->schedule(dp_seq, t, dp_makespan);
-
-            // Solve via branch & bound + List scheduling
-            bnb_solver.init(chain, list_scheduler);
-            bnb_solver.set_upper_bound(dp_seq.makespan());
-            bnb_solver.m_usable_threads = t;
-            jcdp::Sequence bnb_seq_list = bnb_solver.solve();
-
-            // Solve via branch & bound + branch & bound scheduling
-            bnb_solver.init(chain, bnb_scheduler);
-            bnb_solver.set_upper_bound(bnb_seq_list.makespan());
-            bnb_solver.m_usable_threads = t;
-            jcdp::Sequence bnb_seq = bnb_solver.solve();
-
-            std::print(out, "{},", bnb_solver.finished_in_time());
-            std::print(out, "{},", bnb_seq.makespan());
-            std::print(out, "{},", bnb_seq_list.makespan());
-            std::print(out, "{},", dp_makespan);
-            std::print(out, "{}{}", dp_seq.makespan(), (t < len) ? "," : "\n");
+            bnb_solver.set_lower_bound(
+                 std::max(dp_makespans[len - 1], (dp_makespans[0] + t - 1) / t),
+                 t);
          }
+      };
+      trace_chain_id = chain.id;
+
+      // Solve via branch & bound + List scheduling for all thread counts
+      bnb_solver.init(chain, list_scheduler);
+      bnb_solver.m_usable_threads = len;
+      for (std::size_t t = 1; t <= len; ++t) {
+         bnb_solver.set_upper_bound(dp_seqs[t - 1].makespan(), t);
+      }
+      set_lower_bounds();
+      trace_solver = "BnB_List";
+      bnb_solver.set_guide(dp_seqs.back());
+      std::vector<jcdp::Sequence> bnb_seqs_list = bnb_solver.solve_front();
+
+      // Solve via branch & bound + branch & bound scheduling
+      bnb_solver.init(chain, bnb_scheduler);
+      bnb_solver.m_usable_threads = len;
+      for (std::size_t t = 1; t <= len; ++t) {
+         bnb_solver.set_incumbent(bnb_seqs_list[t - 1], t);
+      }
+      set_lower_bounds();
+      trace_solver = "BnB_BnB";
+      bnb_solver.set_guide(dp_seqs.back());
+      std::vector<jcdp::Sequence> bnb_seqs = bnb_solver.solve_front();
+
+      for (std::size_t t = 1; t <= len; ++t) {
+         std::print(*out, "{},", bnb_solver.finished_in_time());
+         std::print(*out, "{},", bnb_seqs[t - 1].makespan());
+         std::print(*out, "{},", bnb_seqs_list[t - 1].makespan());
+         std::print(*out, "{},", dp_makespans[t - 1]);
+         std::print(
+              *out, "{}{}", dp_seqs[t - 1].makespan(), (t < len) ? "," : "\n");
+      }
 
-         out.flush();
+      out->flush();
+      if (trace_out != nullptr) {
+         trace_out->flush();
       }
+      return true;
+   };
 
-      out.close();
+   jcdp::JacobianChain chain;
+   try {
+      if (!chain_file_props.m_chain_file.empty()) {
+         // Replay the chains of the chain file instead of generating them
+         jcdp::ChainFileReader reader(chain_file_props.m_chain_file);
+         while (reader.next(chain)) {
+            if (!solve(chain)) {
+               return -1;
+            }
+         }
+      } else {
+         while (!jcgen.empty()) {
+            if (open_output(jcgen.current_length()) == nullptr) {
+               return -1;
+            }
+            while (jcgen.next(chain)) {
+               if (!solve(chain)) {
+                  return -1;
+               }
+            }
+         }
+      }
+   } catch (const jcdp::BadChainError& bce) {
+      std::println(std::cerr, "{}", bce.what());
+      return -1;
    }
 
    return 0;
@@ -0,0 +1,93 @@
+/******************************************************************************
+ * @file jcdp_calibrate.cpp
+ *
+ * @brief This file is part of the JCDP package. It provides an application
+ *        that measures the seconds per fma of dense multiplications and per
+ *        DAG edge of synthetic tangent / adjoint evaluations on the host over
+ *        the size and DAG size ranges of a given config file. The weights are
+ *        written to a calibration file (second argument, "calibration.in" by
+ *        default) that can be passed to the optimizers via calibration_file.
+ ******************************************************************************/
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+#include "jcdp/calibration.hpp"
+#include "jcdp/util/properties.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> APPLICATION <<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace {
+
+/******************************************************************************
+ * @brief Ranges to measure, shared with the chain generator.
+ ******************************************************************************/
+class CalibrationProperties : public jcdp::util::Properties {
+ public:
+   CalibrationProperties() {
+      register_property(
+           m_size_range, "size_range", "Range of the Jacobian dimensions.");
+      register_property(
+           m_dag_size_range, "dag_size_range",
+           "Range of the amount of edges in the DAG of a single function F.");
+      register_property(
+           m_samples, "calibration_samples",
+           "Amount of sizes measured per range.");
+   }
+
+   std::pair<std::size_t, std::size_t> m_size_range {1, 1};
+   std::pair<std::size_t, std::size_t> m_dag_size_range {1, 1};
+   std::size_t m_samples {8};
+};
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+   CalibrationProperties props;
+   jcdp::Calibration calibration;
+
+   if (argc < 2) {
+      std::println(
+           std::cout, "Usage: {} <config file> [<calibration file>]",
+           argv[0]);
+      props.print_help(std::cout);
+      return -1;
+   }
+
+   const std::filesystem::path config_filename(argv[1]);
+   const std::filesystem::path calibration_filename(
+        (argc > 2) ? argv[2] : "calibration.in");
+   try {
+      props.parse_config(config_filename, true);
+   } catch (const std::runtime_error& bcfe) {
+      std::println(std::cerr, "{}", bcfe.what());
+      return -1;
+   }
+
+   std::println("Calibration properties:");
+   props.print_values(std::cout);
+
+   calibration.measure(
+        props.m_size_range, props.m_dag_size_range,
+        std::max<std::size_t>(props.m_samples, 1));
+   std::println(
+        "\nMultiplication: {} s per fma", calibration.m_multiplication_weight);
+   std::println("Tangent: {} s per edge", calibration.m_tangent_weight);
+   std::println("Adjoint: {} s per edge", calibration.m_adjoint_weight);
+
+   try {
+      calibration.write(calibration_filename);
+   } catch (const std::runtime_error& e) {
+      std::println(std::cerr, "{}", e.what());
+      return -1;
+   }
+   std::println("\nWritten to {}", calibration_filename.string());
+
+   return 0;
+}
@@ -0,0 +1,111 @@
+/******************************************************************************
+ * @file jcdp_execute.cpp
+ *
+ * @brief This file is part of the JCDP package. It provides an application
+ *        that solves a Jacobian chain (generated or read from a chain file)
+ *        via dynamic programming and list scheduling, runs the resulting
+ *        schedule with synthetic kernels on a pinned thread pool and reports
+ *        the measured vs. the predicted times of all operations.
+ ******************************************************************************/
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+
+#include "jcdp/chain_file.hpp"
+#include "jcdp/executor/executor.hpp"
+#include "jcdp/executor/kernels.hpp"
+#include "jcdp/generator.hpp"
+#include "jcdp/jacobian_chain.hpp"
+#include "jcdp/optimizer/dynamic_programming.hpp"
+#include "jcdp/scheduler/priority_list.hpp"
+#include "jcdp/sequence.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> APPLICATION <<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+int main(int argc, char* argv[]) {
+   jcdp::JacobianChainGenerator jcgen;
+   jcdp::ChainFileProperties chain_file_props;
+   jcdp::executor::ExecutorProperties executor_props;
+   jcdp::optimizer::DynamicProgrammingOptimizer dp_solver;
+   jcdp::scheduler::PriorityListScheduler list_scheduler;
+
+   if (argc < 2) {
+      jcgen.print_help(std::cout);
+      dp_solver.print_help(std::cout);
+      executor_props.print_help(std::cout);
+      return -1;
+   }
+
+   const std::filesystem::path config_filename(argv[1]);
+   try {
+      dp_solver.parse_config(config_filename, true);
+      jcgen.parse_config(config_filename, true);
+      jcgen.init_rng();
+      chain_file_props.parse_config(config_filename, true);
+      executor_props.parse_config(config_filename, true);
+   } catch (const std::runtime_error& bcfe) {
+      std::println(std::cerr, "{}", bcfe.what());
+      return -1;
+   }
+
+   std::println("Executor properties:");
+   executor_props.print_values(std::cout);
+
+   jcdp::JacobianChain chain;
+   try {
+      if (chain_file_props.m_chain_file.empty()) {
+         jcgen.next(chain);
+      } else if (!jcdp::ChainFileReader(chain_file_props.m_chain_file)
+                       .next(chain)) {
+         std::println(
+              std::cerr, "No chain in {}", chain_file_props.m_chain_file);
+         return -1;
+      }
+   } catch (const jcdp::BadChainError& bce) {
+      std::println(std::cerr, "{}", bce.what());
+      return -1;
+   }
+   const std::optional<double> seconds_per_fma = dp_solver.calibrate(chain);
+   chain.init_subchains();
+
+   if (seconds_per_fma.has_value()) {
+      std::println("\nCalibrated costs, seconds per fma: {}", *seconds_per_fma);
+   }
+
+   // Solve via dynamic programming + List scheduling
+   dp_solver.init(chain);
+   dp_solver.configure_scheduler(list_scheduler);
+   jcdp::Sequence seq = dp_solver.solve();
+   list_scheduler.schedule(seq, dp_solver.m_usable_threads);
+
+   // The maximum sequence (e.g. one that doesn't fit into memory) would run
+   // a kernel with SIZE_MAX fma
+   if (seq.makespan() == std::numeric_limits<std::size_t>::max()) {
+      std::println(std::cerr, "No feasible sequence for the chain.");
+      return -1;
+   }
+   std::println(
+        "\nOptimized cost (DP + List scheduling): {}\n", seq.makespan());
+   std::println("{}", seq);
+
+   // Run the schedule with synthetic kernels
+   jcdp::executor::SyntheticKernels kernels(
+        chain, seq, executor_props.m_fma_scale);
+   jcdp::executor::Executor executor(
+        kernels.callbacks(), executor_props.m_pin_threads);
+   try {
+      const jcdp::executor::Report report = executor.run(seq);
+      std::println();
+      report.print(std::cout, seq);
+   } catch (const std::exception& e) {
+      std::println(std::cerr, "{}", e.what());
+      return -1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,490 @@
+/******************************************************************************
+ * @file jcdp_server.cpp
+ *
+ * @brief This file is part of the JCDP package. It provides a long-running
+ *        solver service. The solvers are configured once from the config
+ *        file given as the first command line argument. Afterwards, Jacobian
+ *        chains are read line by line from stdin (or from the clients of a
+ *        Unix domain socket whose path is given as the second argument) and
+ *        the scheduled sequences are written back, tagged with the request
+ *        id. Requests are solved concurrently by a pool of workers.
+ ******************************************************************************/
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> INCLUDES <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+#if defined(__unix__)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "jcdp/jacobian.hpp"
+#include "jcdp/jacobian_chain.hpp"
+#include "jcdp/operation.hpp"
+#include "jcdp/optimizer/branch_and_bound.hpp"
+#include "jcdp/optimizer/dynamic_programming.hpp"
+#include "jcdp/scheduler/priority_list.hpp"
+#include "jcdp/sequence.hpp"
+#include "jcdp/util/properties.hpp"
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> APPLICATION <<<<<<<<<<<<<<<<<<<<<<<<<<<<<< //
+
+namespace {
+
+/******************************************************************************
+ * @brief Properties of the server itself.
+ ******************************************************************************/
+class ServerProperties : public jcdp::util::Properties {
+ public:
+   ServerProperties() {
+      register_property(
+           m_workers, "workers",
+           "Amount of requests that are solved concurrently by the server.");
+      register_property(
+           m_time_to_solve, "time_to_solve",
+           "Default time budget of a request for the branch & bound solver "
+           "in seconds.");
+   }
+
+   std::size_t m_workers {1};
+   double m_time_to_solve {-1};
+};
+
+/******************************************************************************
+ * @brief Line-based, bidirectional connection to a client. Writing is
+ *        thread-safe, reading is only done by a single thread.
+ ******************************************************************************/
+class Connection {
+ public:
+   virtual ~Connection() = default;
+
+   virtual auto read_line(std::string& line) -> bool = 0;
+
+   inline auto write_line(const std::string& line) -> void {
+      std::lock_guard lock(m_mutex);
+      send(line + '\n');
+   }
+
+ protected:
+   virtual auto send(std::string_view data) -> void = 0;
+
+ private:
+   std::mutex m_mutex;
+};
+
+class StreamConnection : public Connection {
+ public:
+   StreamConnection(std::istream& in, std::ostream& out) noexcept
+        : m_in(in), m_out(out) {}
+
+   virtual auto read_line(std::string& line) -> bool override final {
+      return static_cast<bool>(std::getline(m_in, line));
+   }
+
+ protected:
+   virtual auto send(std::string_view data) -> void override final {
+      m_out << data << std::flush;
+   }
+
+ private:
+   std::istream& m_in;
+   std::ostream& m_out;
+};
+
+#if defined(__unix__)
+class SocketConnection : public Connection {
+ public:
+   explicit SocketConnection(const int fd) noexcept : m_fd(fd) {}
+
+   virtual ~SocketConnection() {
+      close(m_fd);
+   }
+
+   virtual auto read_line(std::string& line) -> bool override final {
+      std::size_t end;
+      while ((end = m_buffer.find('\n')) == std::string::npos) {
+         char chunk[4096];
+         const ssize_t len = recv(m_fd, chunk, sizeof(chunk), 0);
+         if (len <= 0) {
+            return false;
+         }
+         m_buffer.append(chunk, static_cast<std::size_t>(len));
+      }
+
+      line = m_buffer.substr(0, end);
+      m_buffer.erase(0, end + 1);
+      return true;
+   }
+
+   //! Unblocks a pending read_line(), e.g. on shutdown of the server.
+   inline auto stop_reading() -> void {
+      ::shutdown(m_fd, SHUT_RD);
+   }
+
+ protected:
+   virtual auto send(std::string_view data) -> void override final {
+      // A client that disconnected early simply doesn't get its responses
+      while (!data.empty()) {
+         const ssize_t len = ::send(
+              m_fd, data.data(), data.size(), MSG_NOSIGNAL);
+         if (len <= 0) {
+            return;
+         }
+         data.remove_prefix(static_cast<std::size_t>(len));
+      }
+   }
+
+ private:
+   int m_fd;
+   std::string m_buffer {};
+};
+#endif
+
+/******************************************************************************
+ * @brief A single chain to solve. The line format is
+ *
+ *    <id> <time_to_solve> <length> {<n> <m> <edges_in_dag> <tangent_cost>
+ *    <adjoint_cost>}
+ *
+ * with one group in braces per elemental Jacobian. A negative time uses the
+ * time_to_solve of the config, zero skips the branch & bound solver.
+ ******************************************************************************/
+struct Request {
+   std::string id {};
+   double time_to_solve {-1};
+   std::vector<jcdp::Jacobian> jacobians {};
+   std::shared_ptr<Connection> connection {};
+};
+
+inline auto parse_request(const std::string& line, Request& request) -> void {
+   std::istringstream in(line);
+   std::size_t length = 0;
+   if (!(in >> request.id >> request.time_to_solve >> length) || length == 0) {
+      throw std::runtime_error("Expected <id> <time_to_solve> <length>.");
+   }
+
+   request.jacobians.resize(length);
+   for (std::size_t idx = 0; idx < length; ++idx) {
+      jcdp::Jacobian& jac = request.jacobians[idx];
+      if (!(in >> jac.n >> jac.m >> jac.edges_in_dag >> jac.tangent_cost >>
+            jac.adjoint_cost)) {
+         throw std::runtime_error(
+              "Expected 5 values per elemental Jacobian.");
+      }
+      if (idx > 0 && request.jacobians[idx - 1].m != jac.n) {
+         throw std::runtime_error("Sizes of the elemental Jacobians differ.");
+      }
+      jac.i = idx;
+      jac.j = idx + 1;
+   }
+}
+
+//! Formats a scheduled sequence as
+//! <id> ok <makespan> <finished> {<action>:<mode>:<j>:<k>:<i>:<thread>:<start>}
+inline auto format_response(
+     const std::string& id, jcdp::Sequence& sequence, const bool finished)
+     -> std::string {
+   std::string response = std::format(
+        "{} ok {} {:d}", id, sequence.makespan(), finished);
+   for (const jcdp::Operation& op : sequence) {
+      std::format_to(
+           std::back_inserter(response), " {}:{}:{}:{}:{}:{}:{}", op.action,
+           (op.mode == jcdp::Mode::NONE) ? "---" : std::format("{}", op.mode),
+           op.j, op.k, op.i, op.thread, op.start_time);
+   }
+   return response;
+}
+
+/******************************************************************************
+ * @brief Queue of pending requests, shared by all connections and workers.
+ ******************************************************************************/
+class RequestQueue {
+ public:
+   inline auto push(Request&& request) -> void {
+      {
+         std::lock_guard lock(m_mutex);
+         m_requests.push_back(std::move(request));
+      }
+      m_condition.notify_one();
+   }
+
+   //! Blocks until a request is available. Returns false once the queue is
+   //! closed and empty.
+   inline auto pop(Request& request) -> bool {
+      std::unique_lock lock(m_mutex);
+      m_condition.wait(lock, [this]() -> bool {
+         return m_closed || !m_requests.empty();
+      });
+      if (m_requests.empty()) {
+         return false;
+      }
+
+      request = std::move(m_requests.front());
+      m_requests.pop_front();
+      return true;
+   }
+
+   inline auto close() -> void {
+      {
+         std::lock_guard lock(m_mutex);
+         m_closed = true;
+      }
+      m_condition.notify_all();
+   }
+
+ private:
+   std::mutex m_mutex;
+   std::condition_variable m_condition;
+   std::deque<Request> m_requests {};
+   bool m_closed {false};
+};
+
+/******************************************************************************
+ * @brief Solver state of a single worker. Configured once and reused for
+ *        all requests the worker handles.
+ ******************************************************************************/
+class Worker {
+ public:
+   Worker(const std::string& config, const double time_to_solve)
+        : m_time_to_solve(time_to_solve) {
+      std::istringstream dp_config(config);
+      m_dp_solver.parse_config(dp_config, true);
+
+      // fork() is not safe in the multi-threaded server
+      std::istringstream bnb_config(config + "\nprocesses 1\n");
+      m_bnb_solver.parse_config(bnb_config, true);
+   }
+
+   inline auto solve(const Request& request) -> std::string {
+      m_chain.elemental_jacobians = request.jacobians;
+      m_dp_solver.calibrate(m_chain);
+      m_chain.init_subchains();
+
+      // Dynamic programming + list scheduling as a first incumbent
+      m_dp_solver.init(m_chain);
+      m_dp_solver.configure_scheduler(*m_list_scheduler);
+      jcdp::Sequence sequence = m_dp_solver.solve();
+      m_list_scheduler->schedule(sequence, m_dp_solver.m_usable_threads);
+
+      const double time_to_solve = (request.time_to_solve < 0)
+                                        ? m_time_to_solve
+                                        : request.time_to_solve;
+      if (time_to_solve == 0 || m_chain.length() < 2) {
+         return format_response(request.id, sequence, true);
+      }
+
+      m_bnb_solver.init(m_chain, m_list_scheduler);
+      m_bnb_solver.set_timer(time_to_solve);
+      m_bnb_solver.set_incumbent(sequence);
+      m_bnb_solver.set_guide(sequence);
+      jcdp::Sequence bnb_sequence = m_bnb_solver.solve();
+
+      return format_response(
+           request.id, bnb_sequence, m_bnb_solver.finished_in_time());
+   }
+
+ private:
+   double m_time_to_solve;
+   jcdp::JacobianChain m_chain {};
+   jcdp::optimizer::DynamicProgrammingOptimizer m_dp_solver {};
+   jcdp::optimizer::BranchAndBoundOptimizer m_bnb_solver {};
+   std::shared_ptr<jcdp::scheduler::PriorityListScheduler> m_list_scheduler =
+        std::make_shared<jcdp::scheduler::PriorityListScheduler>();
+};
+
+//! Reads requests from a connection until it is closed. Returns true if the
+//! client requested the shutdown of the server.
+inline auto serve(
+     const std::shared_ptr<Connection>& connection, RequestQueue& queue)
+     -> bool {
+   std::string line;
+   while (connection->read_line(line)) {
+      if (line.empty() || line.starts_with('#')) {
+         continue;
+      }
+      if (line == "shutdown") {
+         return true;
+      }
+
+      Request request {.connection = connection};
+      try {
+         parse_request(line, request);
+      } catch (const std::runtime_error& error) {
+         connection->write_line(
+              std::format("{} error {}", request.id, error.what()));
+         continue;
+      }
+      queue.push(std::move(request));
+   }
+   return false;
+}
+
+#if defined(__unix__)
+//! Accepts clients on a Unix domain socket until one of them requests the
+//! shutdown of the server.
+inline auto serve_socket(const std::string& path, RequestQueue& queue)
+     -> bool {
+   sockaddr_un address {};
+   address.sun_family = AF_UNIX;
+   if (path.size() >= sizeof(address.sun_path)) {
+      std::println(std::cerr, "Socket path is too long: {}", path);
+      return false;
+   }
+   std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+   const int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+   unlink(path.c_str());
+   if (listen_fd < 0 ||
+       bind(listen_fd, static_cast<sockaddr*>(static_cast<void*>(&address)),
+            sizeof(address)) != 0 ||
+       listen(listen_fd, SOMAXCONN) != 0) {
+      std::println(std::cerr, "Failed to listen on {}", path);
+      return false;
+   }
+
+   struct Client {
+      std::shared_ptr<SocketConnection> connection {};
+      std::atomic<bool> is_done {false};
+      std::jthread thread {};
+   };
+
+   std::mutex clients_mutex;
+   std::list<Client> clients {};
+
+   int client_fd;
+   while ((client_fd = accept(listen_fd, nullptr, nullptr)) >= 0) {
+      std::lock_guard lock(clients_mutex);
+      clients.remove_if([](const Client& client) -> bool {
+         return client.is_done;
+      });
+
+      Client& client = clients.emplace_back();
+      client.connection = std::make_shared<SocketConnection>(client_fd);
+      client.thread = std::jthread([&]() -> void {
+         if (serve(client.connection, queue)) {
+            // Unblocks accept() and all other clients
+            ::shutdown(listen_fd, SHUT_RDWR);
+            std::lock_guard shutdown_lock(clients_mutex);
+            for (Client& other : clients) {
+               other.connection->stop_reading();
+            }
+         }
+         client.is_done = true;
+      });
+   }
+
+   // The shutdown client may still walk the list, hence stop and join all
+   // clients before it is cleared
+   {
+      std::lock_guard lock(clients_mutex);
+      for (Client& client : clients) {
+         client.connection->stop_reading();
+      }
+   }
+   for (Client& client : clients) {
+      if (client.thread.joinable()) {
+         client.thread.join();
+      }
+   }
+   {
+      std::lock_guard lock(clients_mutex);
+      clients.clear();
+   }
+   close(listen_fd);
+   unlink(path.c_str());
+   return true;
+}
+#endif
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+   ServerProperties server_properties;
+
+   if (argc < 2) {
+      std::println(
+           std::cout, "Usage: {} <config file> [<socket path>]", argv[0]);
+      server_properties.print_help(std::cout);
+      return -1;
+   }
+
+   // The config file is only read once and then applied to every solver
+   std::ifstream config_file(argv[1]);
+   std::stringstream config;
+   config << config_file.rdbuf();
+
+   std::vector<std::unique_ptr<Worker>> workers {};
+   try {
+      if (!config_file) {
+         throw jcdp::util::BadConfigFileError();
+      }
+      server_properties.parse_config(config, true);
+      for (std::size_t w = 0; w < std::max<std::size_t>(
+                                       server_properties.m_workers, 1);
+           ++w) {
+         workers.push_back(std::make_unique<Worker>(
+              config.str(), server_properties.m_time_to_solve));
+      }
+   } catch (const std::runtime_error& bcfe) {
+      std::println(std::cerr, "{}", bcfe.what());
+      return -1;
+   }
+
+   RequestQueue queue;
+   std::vector<std::jthread> worker_threads {};
+   for (const std::unique_ptr<Worker>& worker : workers) {
+      worker_threads.emplace_back([&queue, &worker]() -> void {
+         Request request;
+         while (queue.pop(request)) {
+            std::string response;
+            try {
+               response = worker->solve(request);
+            } catch (const std::exception& error) {
+               response = std::format("{} error {}", request.id, error.what());
+            }
+            request.connection->write_line(response);
+         }
+      });
+   }
+
+   int status = 0;
+   if (argc > 2) {
+#if defined(__unix__)
+      status = serve_socket(argv[2], queue) ? 0 : -1;
+#else
+      std::println(std::cerr, "Unix domain sockets are not supported.");
+      status = -1;
+#endif
+   } else {
+      serve(std::make_shared<StreamConnection>(std::cin, std::cout), queue);
+   }
+
+   // Finish all pending requests
+   queue.close();
+   worker_threads.clear();
+
+   return status;
+}